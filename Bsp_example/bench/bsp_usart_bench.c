@@ -0,0 +1,224 @@
+/**
+ * @file bsp_usart_bench.c
+ *
+ * This file contains the multi port DMA USART throughput benchmark
+ *
+ * Copyright (c) 2023 admaunaloa admaunaloa@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * All the DMA capable ports of the board run at once on the host DMA model
+ * (per_host_dma_f4.h). Every port transmits frames that the model loops back
+ * from DR into its circular receive buffer, the application checks them in
+ * place with bsp_usart_peek() and bsp_usart_consume(). Only the application
+ * side is timed, so the result is the software cost per byte, not the model.
+ *
+ * Build and run on a Linux host:
+ *     gcc -O2 -DPER_HOST -IF4/inc -IF439XX/inc -IBsp_example -IBsp_example/inc Bsp_example/bench/bsp_usart_bench.c Bsp_example/src/bsp_usart.c F4/src/per_*.c -o bsp_usart_bench
+ *     ./bsp_usart_bench [rounds]
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L // clock_gettime() is not in ISO C
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bsp_usart.h"
+#include "per_host_dma_f4.h"
+
+/// Frame size
+#define BENCH_FRAME (100)
+
+/// Target RAM of a port, the DMA addresses are target addresses
+#define BENCH_RAM(port) ((uint8_t*)(PER_HOST_BASE + (uintptr_t)0x20000000 + ((uintptr_t)(port) * 0x1000)))
+
+/// Number of ports
+#define BENCH_PORTS (6)
+
+static bsp_usart_data_t bench_inst[BENCH_PORTS]; ///< Port instances
+static uint32_t bench_rx[BENCH_PORTS]; ///< Received bytes per port
+static uint32_t bench_err[BENCH_PORTS]; ///< Received bytes with wrong content per port
+
+/// Bench port
+#define BENCH_PORT(NUM, USART, DMA) \
+static per_inline const bsp_usart_port_t* const bench_port_##NUM(void) \
+{ \
+    static const bsp_usart_port_t port = \
+    { \
+        .Usart = USART, \
+        .RxDma = bsp_dma_##DMA##_rx, \
+        .RxSel = bsp_dma_##DMA##_rx_sel, \
+        .TxDma = bsp_dma_##DMA##_tx, \
+        .TxSel = bsp_dma_##DMA##_tx_sel, \
+        .Buf = BENCH_RAM(NUM), \
+        .Cap = BSP_USART_RX_SIZE, \
+        .Inst = &bench_inst[NUM], \
+    }; \
+    return &port; \
+}
+
+BENCH_PORT(0, per_usart_1, usart1)
+BENCH_PORT(1, per_usart_2, usart2)
+BENCH_PORT(2, per_usart_3, usart3)
+BENCH_PORT(3, per_uart_4, uart4)
+BENCH_PORT(4, per_uart_5, uart5)
+BENCH_PORT(5, per_usart_6, usart6)
+
+/// Transmit frame of a port, in target RAM after the receive buffer
+static uint8_t* bench_frame(uint_fast8_t num)
+{
+    return BENCH_RAM(num) + BSP_USART_RX_SIZE;
+}
+
+/// Driver work of one port in a round: check the received bytes in place, send the next frame
+static per_inline void bench_port(const bsp_usart_port_t* const port, uint_fast8_t num)
+{
+    bsp_usart_span_t span;
+    const uint16_t size = bsp_usart_peek(port, &span);
+    uint_fast8_t part = 0;
+    uint32_t pos = bench_rx[num];
+
+    while (part < 2)
+    {
+        uint16_t idx = 0;
+
+        while (idx < span.Size[part])
+        {
+            bench_err[num] += (span.Data[part][idx] != (uint8_t)(pos % BENCH_FRAME));
+            ++pos;
+            ++idx;
+        }
+
+        ++part;
+    }
+
+    bsp_usart_consume(port, size);
+    bench_rx[num] += size;
+
+    if (!per_dma_en(port->TxDma()))
+    {
+        (void)bsp_usart_transmit(port, bench_frame(num), BENCH_FRAME);
+    }
+}
+
+/// Wire of a port, the model moves the transmitted bytes through DR to the receive stream
+static void bench_wire(const bsp_usart_port_t* const port)
+{
+    const per_dma_stream_t* const tx = port->TxDma();
+    const per_dma_stream_t* const rx = port->RxDma();
+    per_dma_t* const tx_dma = (tx->Conf < &PER_DMA_2_BB->Stream[0]) ? PER_DMA_1_BB : PER_DMA_2_BB;
+    per_dma_t* const rx_dma = (rx->Conf < &PER_DMA_2_BB->Stream[0]) ? PER_DMA_1_BB : PER_DMA_2_BB;
+
+    while (per_host_dma_request(tx_dma, (per_dma_stream_e)(tx->Conf - &tx_dma->Stream[0]), 1) != 0)
+    {
+        (void)per_host_dma_request(rx_dma, (per_dma_stream_e)(rx->Conf - &rx_dma->Stream[0]), 1);
+    }
+}
+
+/// Monotonic time in nanoseconds
+static uint64_t bench_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec;
+}
+
+/// Setup the ports and frames
+static bool bench_setup(void)
+{
+    uint_fast8_t num = 0;
+
+    while (num < BENCH_PORTS)
+    {
+        uint_fast8_t idx = 0;
+
+        while (idx < BENCH_FRAME)
+        {
+            bench_frame(num)[idx] = (uint8_t)idx;
+            ++idx;
+        }
+
+        ++num;
+    }
+
+    return bsp_usart_setup(bench_port_0(), 115200, PER_USART_PS_NONE, PER_USART_M_8, PER_USART_STOP_1_0) &&
+           bsp_usart_setup(bench_port_1(), 115200, PER_USART_PS_NONE, PER_USART_M_8, PER_USART_STOP_1_0) &&
+           bsp_usart_setup(bench_port_2(), 115200, PER_USART_PS_NONE, PER_USART_M_8, PER_USART_STOP_1_0) &&
+           bsp_usart_setup(bench_port_3(), 115200, PER_USART_PS_NONE, PER_USART_M_8, PER_USART_STOP_1_0) &&
+           bsp_usart_setup(bench_port_4(), 115200, PER_USART_PS_NONE, PER_USART_M_8, PER_USART_STOP_1_0) &&
+           bsp_usart_setup(bench_port_5(), 115200, PER_USART_PS_NONE, PER_USART_M_8, PER_USART_STOP_1_0);
+}
+
+/// Benchmark entry
+int main(int argc, char** argv)
+{
+    const uint32_t rounds = (argc > 1) ? (uint32_t)strtoul(argv[1], 0, 0) : 100000;
+    uint64_t driver = 0;
+    uint64_t total = 0;
+    uint32_t round = 0;
+    uint_fast8_t num = 0;
+
+    per_host_dma_reset();
+
+    if (!bench_setup())
+    {
+        printf("setup failed\n");
+        return 1;
+    }
+
+    while (round < rounds)
+    {
+        const uint64_t start = bench_ns();
+
+        bench_port(bench_port_0(), 0);
+        bench_port(bench_port_1(), 1);
+        bench_port(bench_port_2(), 2);
+        bench_port(bench_port_3(), 3);
+        bench_port(bench_port_4(), 4);
+        bench_port(bench_port_5(), 5);
+
+        driver += bench_ns() - start;
+
+        bench_wire(bench_port_0());
+        bench_wire(bench_port_1());
+        bench_wire(bench_port_2());
+        bench_wire(bench_port_3());
+        bench_wire(bench_port_4());
+        bench_wire(bench_port_5());
+
+        ++round;
+    }
+
+    printf("port bytes errors\n");
+
+    while (num < BENCH_PORTS)
+    {
+        printf("%u %u %u\n", (unsigned)num, bench_rx[num], bench_err[num]);
+        total += bench_rx[num];
+        ++num;
+    }
+
+    printf("total %llu bytes, driver %.2f ns/byte, %.1f Mbyte/s\n", (unsigned long long)total,
+           (total != 0) ? ((double)driver / (double)total) : 0.0, (driver != 0) ? ((double)total * 1000.0 / (double)driver) : 0.0);
+
+    return 0;
+}
@@ -0,0 +1,668 @@
+/**
+ * @file bsp_usart_loop.c
+ *
+ * This file contains the USART loopback throughput and latency benchmark
+ *
+ * Copyright (c) 2023 admaunaloa admaunaloa@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * Frames go from the transmitter of USART3 to the receiver of UART4 in three
+ * modes, for every rate of the board baud rate table:
+ * dma   bsp_usart_port_t, bsp_usart_send() queue and bsp_usart_peek() in place
+ * irq   bsp_usart_fifo_port_t, bsp_usart_fifo_write() and bsp_usart_fifo_read()
+ * poll  TXE and RXNE polling, per_usart_set_dr() and per_usart_dr()
+ * A F4 USART has no internal loopback, LBCL only clocks the last bit in
+ * synchronous mode and half-duplex still drives the pin. So the board needs a
+ * wire from USART3_TX (PD8) to UART4_RX (PC11).
+ *
+ * One JSON line per mode and rate:
+ *     {"target":"host","mode":"dma","baud":115200,"frames":32,"bytes":2048,"errors":0,"lost":0,
+ *      "throughput":11505,"efficiency":998,"latency_avg":10929669,"latency_max":11111424,"cpu_ns":56,"load":650}
+ * throughput    received bytes per second
+ * efficiency    throughput relative to the line rate that BRR of the transmitter gives, per mille,
+ *               the nominal baud rate is off by the BRR rounding
+ * latency       from handing a frame to the driver until its last byte is read by the application, ns,
+ *               with LOOP_WINDOW frames in flight so it includes the frame ahead
+ * cpu_ns        driver time per byte, the application calls that moved data and the interrupts
+ * load          driver time relative to the elapsed time, ppm
+ * In the poll mode all the polling calls count, the application has to spin.
+ *
+ * On the host (PER_HOST) the USART and DMA models carry the line
+ * (per_host_usart_f4.h, per_host_dma_f4.h). Throughput and latency are model
+ * time, the driver time is host time, so cpu_ns is the software overhead of the
+ * driver code. The poll load then depends on the model step of a quarter char.
+ * On the board the time is DWT_CYCCNT and stdout must be retargeted, for
+ * example to SWO or semihosting.
+ *
+ * Build and run on a Linux host:
+ *     gcc -O2 -DPER_HOST -IF4/inc -IF439XX/inc -IBsp_example -IBsp_example/inc Bsp_example/bench/bsp_usart_loop.c Bsp_example/src/bsp_usart.c F4/src/per_*.c -o bsp_usart_loop
+ *     ./bsp_usart_loop [frames] > result.jsonl
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L // clock_gettime() is not in ISO C
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bsp_rcc.h"
+#include "bsp_usart.h"
+
+#ifdef PER_HOST
+#include <time.h>
+
+#include "per_host_usart_f4.h"
+#else
+#include "bsp_flash.h"
+#include "bsp_gpio.h"
+#endif
+
+/// Frame size, a divider of 256 so every frame is a part of the ramp
+#define LOOP_FRAME (64)
+
+/// Default number of frames per mode and rate
+#define LOOP_FRAMES (32)
+
+/// Maximum number of frames per mode and rate
+#define LOOP_FRAMES_MAX (1024)
+
+/// Frames in flight, two keep the line busy while the application takes the previous one
+#define LOOP_WINDOW (2)
+
+/// Bits per character, 8N1
+#define LOOP_BITS (10)
+
+/// Frame times without a received byte after which a run stops
+#define LOOP_TIMEOUT (4)
+
+_Static_assert((256 % LOOP_FRAME) == 0, "LOOP_FRAME must divide 256");
+
+#ifdef PER_HOST
+/// Target RAM of the DMA buffers, the DMA addresses are target addresses
+#define LOOP_RAM ((uint8_t*)(PER_HOST_BASE + (uintptr_t)0x20000000))
+
+/// Name of the target in the result
+#define LOOP_TARGET "host"
+#else
+static uint8_t loop_ram[(2 * BSP_USART_RX_SIZE) + 256]; ///< DMA buffers
+
+/// Target RAM of the DMA buffers
+#define LOOP_RAM (loop_ram)
+
+/// Name of the target in the result
+#define LOOP_TARGET "board"
+
+/// CPU clock in MHz after bsp_rcc_init(), the DWT_CYCCNT rate
+#define LOOP_CPU_MHZ (168)
+
+#define LOOP_DEMCR (*(volatile uint32_t*)0xE000EDFC) ///< Debug exception and monitor control register
+#define LOOP_DWT_CTRL (*(volatile uint32_t*)0xE0001000) ///< DWT control register
+#define LOOP_DWT_CYCCNT (*(volatile uint32_t*)0xE0001004) ///< DWT cycle counter
+#define LOOP_NVIC_ISER ((volatile uint32_t*)0xE000E100) ///< NVIC interrupt set enable registers
+
+#define LOOP_IRQ_DMA1_STREAM3 (14) ///< USART3_TX stream interrupt number
+#define LOOP_IRQ_USART3 (39) ///< USART3 interrupt number
+#define LOOP_IRQ_UART4 (52) ///< UART4 interrupt number
+#endif
+
+/// Receive buffer of the DMA mode receiver
+#define LOOP_RX_BUF (LOOP_RAM)
+
+/// Receive buffer of the DMA mode transmitter, not used
+#define LOOP_TX_BUF (LOOP_RAM + BSP_USART_RX_SIZE)
+
+/// Transmitted data, a 256 byte ramp
+#define LOOP_RAMP (LOOP_RAM + (2 * BSP_USART_RX_SIZE))
+
+/// Benchmark modes
+typedef enum
+{
+    LOOP_DMA, ///< DMA streams
+    LOOP_IRQ, ///< Interrupt driven FIFOs
+    LOOP_POLL, ///< Polling
+    LOOP_MODES,
+} loop_mode_e;
+
+/// Result of one mode and rate
+typedef struct
+{
+    uint32_t Bytes; ///< Received bytes
+    uint32_t Errors; ///< Received bytes with wrong content
+    uint32_t Frames; ///< Completely received frames
+    uint64_t Start; ///< Time of the start
+    uint64_t End; ///< Time of the last received byte
+    uint64_t LatSum; ///< Sum of the frame latencies
+    uint64_t LatMax; ///< Largest frame latency
+    uint64_t Cpu; ///< Driver time of the application in clock ticks
+} loop_result_t;
+
+static const char* const loop_name[LOOP_MODES] = {"dma", "irq", "poll"}; ///< Mode names
+static bsp_usart_data_t loop_dma_inst[2]; ///< DMA mode instances
+static bsp_usart_fifo_data_t loop_fifo_inst[2]; ///< Interrupt mode instances
+static uint8_t loop_fifo_buf[4][BSP_USART_FIFO_SIZE]; ///< Interrupt mode FIFOs
+static volatile loop_mode_e loop_mode; ///< Mode in progress
+static loop_result_t loop_res; ///< Result in progress
+static volatile uint64_t loop_irq_cpu; ///< Driver time of the interrupts in clock ticks
+static uint64_t loop_sent[LOOP_FRAMES_MAX]; ///< Time each frame was handed to the driver
+
+/// DMA mode transmitter, USART3
+static per_inline const bsp_usart_port_t* const loop_dma_tx(void)
+{
+    static const bsp_usart_port_t port =
+    {
+        .Usart = per_usart_3,
+        .RxDma = bsp_dma_usart3_rx,
+        .RxSel = bsp_dma_usart3_rx_sel,
+        .TxDma = bsp_dma_usart3_tx,
+        .TxSel = bsp_dma_usart3_tx_sel,
+        .Rates = bsp_usart_rates_apb1,
+        .RateNum = BSP_USART_RATES,
+        .Buf = LOOP_TX_BUF,
+        .Cap = BSP_USART_RX_SIZE,
+        .Inst = &loop_dma_inst[0],
+    };
+    return &port;
+}
+
+/// DMA mode receiver, UART4
+static per_inline const bsp_usart_port_t* const loop_dma_rx(void)
+{
+    static const bsp_usart_port_t port =
+    {
+        .Usart = per_uart_4,
+        .RxDma = bsp_dma_uart4_rx,
+        .RxSel = bsp_dma_uart4_rx_sel,
+        .TxDma = bsp_dma_uart4_tx,
+        .TxSel = bsp_dma_uart4_tx_sel,
+        .Rates = bsp_usart_rates_apb1,
+        .RateNum = BSP_USART_RATES,
+        .Buf = LOOP_RX_BUF,
+        .Cap = BSP_USART_RX_SIZE,
+        .Inst = &loop_dma_inst[1],
+    };
+    return &port;
+}
+
+/// Interrupt mode transmitter, USART3
+static per_inline const bsp_usart_fifo_port_t* const loop_fifo_tx(void)
+{
+    static const bsp_usart_fifo_port_t port =
+    {
+        .Usart = per_usart_3,
+        .Rates = bsp_usart_rates_apb1,
+        .RateNum = BSP_USART_RATES,
+        .RxBuf = loop_fifo_buf[0],
+        .TxBuf = loop_fifo_buf[1],
+        .Mask = BSP_USART_FIFO_SIZE - 1,
+        .Inst = &loop_fifo_inst[0],
+    };
+    return &port;
+}
+
+/// Interrupt mode receiver, UART4
+static per_inline const bsp_usart_fifo_port_t* const loop_fifo_rx(void)
+{
+    static const bsp_usart_fifo_port_t port =
+    {
+        .Usart = per_uart_4,
+        .Rates = bsp_usart_rates_apb1,
+        .RateNum = BSP_USART_RATES,
+        .RxBuf = loop_fifo_buf[2],
+        .TxBuf = loop_fifo_buf[3],
+        .Mask = BSP_USART_FIFO_SIZE - 1,
+        .Inst = &loop_fifo_inst[1],
+    };
+    return &port;
+}
+
+#ifdef PER_HOST
+/// Line time in nanoseconds, the model time
+static uint64_t loop_now(void)
+{
+    return per_host_usart_time();
+}
+
+/// Driver time stamp in clock ticks, the host clock in nanoseconds
+static uint32_t loop_tick(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(((uint64_t)ts.tv_sec * 1000000000u) + (uint64_t)ts.tv_nsec);
+}
+
+/// Nanoseconds of clock ticks
+#define LOOP_TICK_NS(TICK) (TICK)
+#else
+/// Line time in nanoseconds, DWT_CYCCNT extended to 64 bits, call at least once per counter period
+static uint64_t loop_now(void)
+{
+    static uint32_t last;
+    static uint64_t cycles;
+    const uint32_t cnt = LOOP_DWT_CYCCNT;
+
+    cycles += (uint32_t)(cnt - last);
+    last = cnt;
+
+    return (cycles * 1000u) / LOOP_CPU_MHZ;
+}
+
+/// Driver time stamp in clock ticks, the CPU cycles
+static uint32_t loop_tick(void)
+{
+    return LOOP_DWT_CYCCNT;
+}
+
+/// Nanoseconds of clock ticks
+#define LOOP_TICK_NS(TICK) (((TICK) * 1000u) / LOOP_CPU_MHZ)
+#endif
+
+/// USART interrupt, the interrupt mode
+static void loop_usart_irq(const per_usart_t* usart)
+{
+    const uint32_t start = loop_tick();
+
+    if (loop_mode == LOOP_IRQ)
+    {
+        if (usart->Per == per_usart_3()->Per)
+        {
+            bsp_usart_fifo_irq(loop_fifo_tx());
+        }
+        else
+        {
+            bsp_usart_fifo_irq(loop_fifo_rx());
+        }
+    }
+
+    loop_irq_cpu += (uint32_t)(loop_tick() - start);
+}
+
+/// Transmit stream interrupt, the DMA mode queue
+static void loop_dma_irq(void)
+{
+    const uint32_t start = loop_tick();
+
+    if (loop_mode == LOOP_DMA)
+    {
+        bsp_usart_tx_dma_irq(loop_dma_tx());
+    }
+
+    loop_irq_cpu += (uint32_t)(loop_tick() - start);
+}
+
+#ifdef PER_HOST
+/// DMA model interrupt callback
+static void loop_host_dma_irq(per_dma_t* dma, per_dma_stream_e str)
+{
+    if (&dma->Stream[str] == bsp_dma_usart3_tx()->Conf)
+    {
+        loop_dma_irq();
+    }
+}
+#else
+/// USART3 interrupt
+void USART3_IRQHandler(void)
+{
+    loop_usart_irq(per_usart_3());
+}
+
+/// UART4 interrupt
+void UART4_IRQHandler(void)
+{
+    loop_usart_irq(per_uart_4());
+}
+
+/// USART3_TX stream interrupt
+void DMA1_Stream3_IRQHandler(void)
+{
+    loop_dma_irq();
+}
+#endif
+
+/// Check received bytes against the ramp
+static void loop_check(const uint8_t* data, uint32_t size)
+{
+    uint32_t idx = 0;
+
+    while (idx < size)
+    {
+        loop_res.Errors += (data[idx] != (uint8_t)(loop_res.Bytes + idx));
+        ++idx;
+    }
+
+    loop_res.Bytes += size;
+}
+
+/// Hand bytes to the transmitter, returns the number of bytes accepted
+static per_inline uint32_t loop_send(const uint8_t* data, uint32_t size)
+{
+    uint32_t result = 0;
+
+    if (loop_mode == LOOP_DMA)
+    {
+        result = bsp_usart_send(loop_dma_tx(), data, (uint16_t)size, 0) ? size : 0;
+    }
+    else if (loop_mode == LOOP_IRQ)
+    {
+        result = bsp_usart_fifo_write(loop_fifo_tx(), data, size);
+    }
+    else if (per_usart_txe(per_usart_3()) && per_usart_set_dr(per_usart_3(), data[0]))
+    {
+        result = 1;
+    }
+
+    return result;
+}
+
+/// Take and check the received bytes, returns the number of bytes
+static per_inline uint32_t loop_receive(void)
+{
+    uint32_t result = 0;
+
+    if (loop_mode == LOOP_DMA)
+    {
+        bsp_usart_span_t span;
+
+        result = bsp_usart_peek(loop_dma_rx(), &span);
+        loop_check(span.Data[0], span.Size[0]);
+        loop_check(span.Data[1], span.Size[1]);
+        bsp_usart_consume(loop_dma_rx(), (uint16_t)result);
+    }
+    else if (loop_mode == LOOP_IRQ)
+    {
+        uint8_t buf[LOOP_FRAME];
+
+        result = bsp_usart_fifo_read(loop_fifo_rx(), buf, sizeof(buf));
+        loop_check(buf, result);
+    }
+    else if (per_usart_rdclr_rxne(per_uart_4())) // Also clears RXNE of the host model, on the board the DR read does
+    {
+        const uint8_t data = (uint8_t)per_usart_dr(per_uart_4());
+
+        loop_check(&data, 1);
+        result = 1;
+    }
+
+    return result;
+}
+
+/// Let the line run, on the host the models advance a quarter char
+static void loop_line(uint64_t char_ns)
+{
+#ifdef PER_HOST
+    (void)per_host_usart_run((char_ns / 4) + 1);
+#else
+    (void)char_ns;
+#endif
+}
+
+/// Stop both USARTs, their streams and interrupts
+static void loop_stop(void)
+{
+    const per_usart_t* const usart[2] = {per_usart_3(), per_uart_4()};
+    const per_dma_stream_t* const dma[4] = {bsp_dma_usart3_rx(), bsp_dma_usart3_tx(), bsp_dma_uart4_rx(), bsp_dma_uart4_tx()};
+    uint_fast8_t idx = 0;
+
+    while (idx < 2)
+    {
+        per_usart_set_ue(usart[idx], false);
+        per_usart_set_dmat(usart[idx], false);
+        per_usart_set_dmar(usart[idx], false);
+        per_usart_set_txeie(usart[idx], false);
+        per_usart_set_rxneie(usart[idx], false);
+        per_usart_set_idleie(usart[idx], false);
+        per_usart_set_tcie(usart[idx], false);
+        ++idx;
+    }
+
+    idx = 0;
+
+    while (idx < 4)
+    {
+        per_dma_set_en(dma[idx], false);
+
+        while (per_dma_en(dma[idx]))
+        {
+        }
+
+        ++idx;
+    }
+}
+
+/// Configure both USARTs for a mode and a rate
+static bool loop_setup(loop_mode_e mode, uint32_t rate)
+{
+#ifdef PER_HOST
+    const per_host_usart_link_t link =
+    {
+        .Tx = per_usart_3(),
+        .Rx = per_uart_4(),
+        .TxDma = bsp_dma_usart3_tx(),
+        .RxDma = bsp_dma_uart4_rx(),
+        .Freq = BSP_RCC_APB1_FREQ,
+    };
+#endif
+    uint_fast16_t idx = 0;
+    bool result;
+
+    loop_stop();
+    memset(loop_dma_inst, 0, sizeof(loop_dma_inst));
+    memset(loop_fifo_inst, 0, sizeof(loop_fifo_inst));
+#ifdef PER_HOST
+    per_host_clear();
+    per_host_dma_reset();
+    per_host_usart_reset();
+#endif
+
+    while (idx < 256)
+    {
+        LOOP_RAMP[idx] = (uint8_t)idx;
+        ++idx;
+    }
+
+    loop_mode = mode;
+
+    if (mode == LOOP_DMA)
+    {
+        result = bsp_usart_setup(loop_dma_tx(), rate, PER_USART_PS_NONE, PER_USART_M_8, PER_USART_STOP_1_0) &&
+                 bsp_usart_setup(loop_dma_rx(), rate, PER_USART_PS_NONE, PER_USART_M_8, PER_USART_STOP_1_0);
+    }
+    else
+    {
+        result = bsp_usart_fifo_setup(loop_fifo_tx(), rate, PER_USART_PS_NONE, PER_USART_M_8, PER_USART_STOP_1_0) &&
+                 bsp_usart_fifo_setup(loop_fifo_rx(), rate, PER_USART_PS_NONE, PER_USART_M_8, PER_USART_STOP_1_0);
+
+        if (mode == LOOP_POLL) // Same setting without the receive interrupt
+        {
+            per_usart_set_rxneie(per_usart_3(), false);
+            per_usart_set_rxneie(per_uart_4(), false);
+        }
+    }
+
+    per_usart_set_ue(per_usart_3(), true);
+    per_usart_set_ue(per_uart_4(), true);
+
+#ifdef PER_HOST
+    per_host_dma_set_irq(loop_host_dma_irq);
+    per_host_usart_set_irq(loop_usart_irq);
+    result = result && per_host_usart_connect(&link);
+#endif
+
+    return result;
+}
+
+/// Line rate of the transmitter from BRR and OVER8, fck / (16 * USARTDIV) or fck / (8 * USARTDIV)
+static uint32_t loop_line_rate(void)
+{
+    const per_usart_t* const usart = per_usart_3();
+    const uint32_t mant = per_usart_div_mantissa(usart);
+    const uint32_t frac = per_usart_div_fraction(usart);
+    const uint32_t div = per_usart_over8(usart) ? ((mant * 8u) + (frac & 7u)) : ((mant * 16u) + frac);
+
+    return (div != 0) ? (BSP_RCC_APB1_FREQ / div) : 0;
+}
+
+/// Print the result line of a mode and rate, line is the rate of loop_line_rate()
+static void loop_print(loop_mode_e mode, uint32_t rate, uint32_t line, uint32_t frames)
+{
+    const uint64_t time = loop_res.End - loop_res.Start;
+    const uint64_t cpu = LOOP_TICK_NS(loop_res.Cpu + loop_irq_cpu);
+    const uint64_t tput = (time != 0) ? (((uint64_t)loop_res.Bytes * 1000000000u) / time) : 0;
+
+    printf("{\"target\":\"%s\",\"mode\":\"%s\",\"baud\":%lu,\"frames\":%lu,\"bytes\":%lu,\"errors\":%lu,\"lost\":%lu,"
+           "\"throughput\":%lu,\"efficiency\":%lu,\"latency_avg\":%lu,\"latency_max\":%lu,\"cpu_ns\":%lu,\"load\":%lu}\n",
+           LOOP_TARGET, loop_name[mode], (unsigned long)rate, (unsigned long)loop_res.Frames, (unsigned long)loop_res.Bytes,
+           (unsigned long)loop_res.Errors, (unsigned long)((frames * LOOP_FRAME) - loop_res.Bytes), (unsigned long)tput,
+           (unsigned long)((line != 0) ? ((tput * LOOP_BITS * 1000u) / line) : 0),
+           (unsigned long)((loop_res.Frames != 0) ? (loop_res.LatSum / loop_res.Frames) : 0), (unsigned long)loop_res.LatMax,
+           (unsigned long)((loop_res.Bytes != 0) ? (cpu / loop_res.Bytes) : 0), (unsigned long)((time != 0) ? ((cpu * 1000000u) / time) : 0));
+}
+
+/// Run one mode at one rate, the transmitter sends the frames back to back with LOOP_WINDOW frames in flight
+static void loop_run(loop_mode_e mode, uint32_t rate, uint32_t frames)
+{
+    const uint64_t char_ns = ((uint64_t)LOOP_BITS * 1000000000u) / rate;
+    const uint64_t timeout = (uint64_t)LOOP_TIMEOUT * LOOP_FRAME * char_ns;
+    const uint32_t total = frames * LOOP_FRAME;
+    uint32_t sent = 0;
+    uint32_t line;
+    uint64_t last;
+
+    memset(&loop_res, 0, sizeof(loop_res));
+    loop_irq_cpu = 0;
+
+    if (!loop_setup(mode, rate))
+    {
+        loop_stop();
+        printf("{\"target\":\"%s\",\"mode\":\"%s\",\"baud\":%lu,\"error\":\"setup\"}\n", LOOP_TARGET, loop_name[mode], (unsigned long)rate);
+        return;
+    }
+
+    line = loop_line_rate();
+    loop_res.Start = loop_now();
+    loop_res.End = loop_res.Start;
+    last = loop_res.Start;
+
+    while ((loop_res.Bytes < total) && ((loop_now() - last) < timeout))
+    {
+        const uint64_t now = loop_now();
+        const uint32_t start = loop_tick();
+        const uint32_t off = sent % LOOP_FRAME;
+        uint32_t tx = 0;
+        uint32_t rx;
+
+        if ((sent < total) && ((off != 0) || ((sent - loop_res.Bytes) <= ((LOOP_WINDOW - 1) * LOOP_FRAME))))
+        {
+            tx = loop_send(LOOP_RAMP + (sent & 0xFF), LOOP_FRAME - off); // Rest of the frame
+
+            if ((tx != 0) && (off == 0))
+            {
+                loop_sent[sent / LOOP_FRAME] = now;
+            }
+
+            sent += tx;
+        }
+
+        rx = loop_receive();
+
+        if ((mode == LOOP_POLL) || (tx != 0) || (rx != 0)) // Only the polling spins in the driver
+        {
+            loop_res.Cpu += (uint32_t)(loop_tick() - start);
+        }
+
+        if (rx != 0)
+        {
+            last = now;
+            loop_res.End = now;
+
+            while ((loop_res.Frames < frames) && (loop_res.Bytes >= ((loop_res.Frames + 1) * LOOP_FRAME)))
+            {
+                const uint64_t lat = now - loop_sent[loop_res.Frames];
+
+                loop_res.LatSum += lat;
+                loop_res.LatMax = (lat > loop_res.LatMax) ? lat : loop_res.LatMax;
+                loop_res.Frames++;
+            }
+        }
+
+        loop_line(char_ns);
+    }
+
+    loop_stop();
+    loop_print(mode, rate, line, frames);
+}
+
+/// Run all the modes at all the rates of the board table
+static void loop_all(uint32_t frames)
+{
+    uint_fast8_t mode = 0;
+
+    while (mode < LOOP_MODES)
+    {
+        uint_fast8_t idx = 0;
+
+        while (idx < BSP_USART_RATES)
+        {
+            loop_run((loop_mode_e)mode, bsp_usart_rates_apb1[idx].Rate, frames);
+            ++idx;
+        }
+
+        ++mode;
+    }
+}
+
+#ifdef PER_HOST
+/// Benchmark entry, the optional argument is the number of frames per mode and rate
+int main(int argc, char** argv)
+{
+    uint32_t frames = (argc > 1) ? (uint32_t)strtoul(argv[1], 0, 0) : LOOP_FRAMES;
+
+    if ((frames == 0) || (frames > LOOP_FRAMES_MAX))
+    {
+        frames = LOOP_FRAMES_MAX;
+    }
+
+    loop_all(frames);
+
+    return 0;
+}
+#else
+/// Benchmark entry
+int main(void)
+{
+    bsp_flash_init();
+    bsp_rcc_init();
+    bsp_gpio_init();
+
+    LOOP_DEMCR |= (1u << 24); // TRCENA
+    LOOP_DWT_CYCCNT = 0;
+    LOOP_DWT_CTRL |= 1u; // CYCCNTENA
+
+    LOOP_NVIC_ISER[LOOP_IRQ_DMA1_STREAM3 / 32] = 1u << (LOOP_IRQ_DMA1_STREAM3 % 32);
+    LOOP_NVIC_ISER[LOOP_IRQ_USART3 / 32] = 1u << (LOOP_IRQ_USART3 % 32);
+    LOOP_NVIC_ISER[LOOP_IRQ_UART4 / 32] = 1u << (LOOP_IRQ_UART4 % 32);
+
+    loop_all(LOOP_FRAMES);
+
+    while (1)
+    {
+    }
+}
+#endif
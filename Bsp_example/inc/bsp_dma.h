@@ -0,0 +1,166 @@
+/**
+ * @file bsp_dma.h
+ *
+ * This file contains the DMA stream allocation of the board
+ *
+ * Generated by tools/per_dma_alloc.py, do not edit.
+ */
+
+#ifndef bsp_dma_h_
+#define bsp_dma_h_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "per_dma.h"
+
+/// UART4_RX: DMA1 stream 2 channel 4
+static per_inline const per_dma_stream_t* const bsp_dma_uart4_rx(void)
+{
+    return per_dma_1_stream_2();
+}
+
+/// UART4_RX stream-channel selection
+static per_inline const per_dma_selection_t* const bsp_dma_uart4_rx_sel(void)
+{
+    return &PER_DMA_1_STREAM_2_UART4_RX;
+}
+
+/// UART4_TX: DMA1 stream 4 channel 4
+static per_inline const per_dma_stream_t* const bsp_dma_uart4_tx(void)
+{
+    return per_dma_1_stream_4();
+}
+
+/// UART4_TX stream-channel selection
+static per_inline const per_dma_selection_t* const bsp_dma_uart4_tx_sel(void)
+{
+    return &PER_DMA_1_STREAM_4_UART4_TX;
+}
+
+/// UART5_RX: DMA1 stream 0 channel 4
+static per_inline const per_dma_stream_t* const bsp_dma_uart5_rx(void)
+{
+    return per_dma_1_stream_0();
+}
+
+/// UART5_RX stream-channel selection
+static per_inline const per_dma_selection_t* const bsp_dma_uart5_rx_sel(void)
+{
+    return &PER_DMA_1_STREAM_0_UART5_RX;
+}
+
+/// UART5_TX: DMA1 stream 7 channel 4
+static per_inline const per_dma_stream_t* const bsp_dma_uart5_tx(void)
+{
+    return per_dma_1_stream_7();
+}
+
+/// UART5_TX stream-channel selection
+static per_inline const per_dma_selection_t* const bsp_dma_uart5_tx_sel(void)
+{
+    return &PER_DMA_1_STREAM_7_UART5_TX;
+}
+
+/// USART1_RX: DMA2 stream 2 channel 4
+static per_inline const per_dma_stream_t* const bsp_dma_usart1_rx(void)
+{
+    return per_dma_2_stream_2();
+}
+
+/// USART1_RX stream-channel selection
+static per_inline const per_dma_selection_t* const bsp_dma_usart1_rx_sel(void)
+{
+    return &PER_DMA_2_STREAM_2_USART1_RX;
+}
+
+/// USART1_TX: DMA2 stream 7 channel 4
+static per_inline const per_dma_stream_t* const bsp_dma_usart1_tx(void)
+{
+    return per_dma_2_stream_7();
+}
+
+/// USART1_TX stream-channel selection
+static per_inline const per_dma_selection_t* const bsp_dma_usart1_tx_sel(void)
+{
+    return &PER_DMA_2_STREAM_7_USART1_TX;
+}
+
+/// USART2_RX: DMA1 stream 5 channel 4
+static per_inline const per_dma_stream_t* const bsp_dma_usart2_rx(void)
+{
+    return per_dma_1_stream_5();
+}
+
+/// USART2_RX stream-channel selection
+static per_inline const per_dma_selection_t* const bsp_dma_usart2_rx_sel(void)
+{
+    return &PER_DMA_1_STREAM_5_USART2_RX;
+}
+
+/// USART2_TX: DMA1 stream 6 channel 4
+static per_inline const per_dma_stream_t* const bsp_dma_usart2_tx(void)
+{
+    return per_dma_1_stream_6();
+}
+
+/// USART2_TX stream-channel selection
+static per_inline const per_dma_selection_t* const bsp_dma_usart2_tx_sel(void)
+{
+    return &PER_DMA_1_STREAM_6_USART2_TX;
+}
+
+/// USART3_RX: DMA1 stream 1 channel 4
+static per_inline const per_dma_stream_t* const bsp_dma_usart3_rx(void)
+{
+    return per_dma_1_stream_1();
+}
+
+/// USART3_RX stream-channel selection
+static per_inline const per_dma_selection_t* const bsp_dma_usart3_rx_sel(void)
+{
+    return &PER_DMA_1_STREAM_1_USART3_RX;
+}
+
+/// USART3_TX: DMA1 stream 3 channel 4
+static per_inline const per_dma_stream_t* const bsp_dma_usart3_tx(void)
+{
+    return per_dma_1_stream_3();
+}
+
+/// USART3_TX stream-channel selection
+static per_inline const per_dma_selection_t* const bsp_dma_usart3_tx_sel(void)
+{
+    return &PER_DMA_1_STREAM_3_USART3_TX;
+}
+
+/// USART6_RX: DMA2 stream 1 channel 5
+static per_inline const per_dma_stream_t* const bsp_dma_usart6_rx(void)
+{
+    return per_dma_2_stream_1();
+}
+
+/// USART6_RX stream-channel selection
+static per_inline const per_dma_selection_t* const bsp_dma_usart6_rx_sel(void)
+{
+    return &PER_DMA_2_STREAM_1_USART6_RX;
+}
+
+/// USART6_TX: DMA2 stream 6 channel 5
+static per_inline const per_dma_stream_t* const bsp_dma_usart6_tx(void)
+{
+    return per_dma_2_stream_6();
+}
+
+/// USART6_TX stream-channel selection
+static per_inline const per_dma_selection_t* const bsp_dma_usart6_tx_sel(void)
+{
+    return &PER_DMA_2_STREAM_6_USART6_TX;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // bsp_dma_h_
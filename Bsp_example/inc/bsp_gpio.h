@@ -39,6 +39,8 @@ extern "C" {
 #define bsp_gpio_led_red()          (per_gpio_b_out(PER_GPIO_PIN_14))
 
 /// GPIOC
+#define bsp_gpio_uart4_tx()         (per_gpio_c_out(PER_GPIO_PIN_10))
+#define bsp_gpio_uart4_rx()         (per_gpio_c_in(PER_GPIO_PIN_11))
 #define bsp_user_button_1()         (per_gpio_c_in(PER_GPIO_PIN_13))
 
 /// GPIOD
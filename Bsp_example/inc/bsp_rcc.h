@@ -31,6 +31,12 @@
 extern "C" {
 #endif
 
+/// APB1 peripheral clock frequency set by bsp_rcc_init()
+#define BSP_RCC_APB1_FREQ (42000000)
+
+/// APB2 peripheral clock frequency set by bsp_rcc_init()
+#define BSP_RCC_APB2_FREQ (42000000)
+
 void bsp_rcc_init(void);
 
 #ifdef __cplusplus
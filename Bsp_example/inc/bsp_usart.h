@@ -32,179 +32,641 @@ extern "C" {
 #endif
 
 #include "bsp_dep.h"
+#include "bsp_dma.h"
 #include "per_dma.h"
 #include "per_usart.h"
 
-/// Descriptor Read-write bit
+/// USART receive buffer size of the board ports
+#define BSP_USART_RX_SIZE (256)
+
+/// Transmit queue entries per port, a power of two
+#ifndef BSP_USART_TX_QUEUE
+#define BSP_USART_TX_QUEUE (8)
+#endif
+
+_Static_assert((BSP_USART_TX_QUEUE & (BSP_USART_TX_QUEUE - 1)) == 0, "BSP_USART_TX_QUEUE must be a power of two");
+
+/// Receive and transmit FIFO size of the board interrupt driven ports, a power of two
+#define BSP_USART_FIFO_SIZE (64)
+
+_Static_assert((BSP_USART_FIFO_SIZE & (BSP_USART_FIFO_SIZE - 1)) == 0, "BSP_USART_FIFO_SIZE must be a power of two");
+
+/// Receive event, the reason a part of the receive buffer is handed over
+typedef enum
+{
+    BSP_USART_EVENT_HALF, ///< DMA half transfer, the first half of the receive buffer is filled
+    BSP_USART_EVENT_FULL, ///< DMA transfer complete, the receive buffer is filled up to the end
+    BSP_USART_EVENT_IDLE, ///< USART idle line, end of a frame
+} bsp_usart_event_e;
+
+struct bsp_usart_port_s;
+
+/// Receive event callback, a part of the receive buffer with offset and length, called from the interrupt
+typedef void (*bsp_usart_frame_t)(const struct bsp_usart_port_s* port, uint16_t offset, uint16_t length, bsp_usart_event_e event);
+
+/// Transmit completion callback, called from the interrupt when the data is sent and may be reused
+typedef void (*bsp_usart_sent_t)(const struct bsp_usart_port_s* port, const uint8_t* data, uint16_t size);
+
+/// Transmit queue entry
 typedef struct
 {
-    bool (*Setup)(uint8_t*, uint32_t, uint32_t, per_usart_ps_e, per_usart_m_e, per_usart_stop_e); //!< Configure parameters
-    void (*Enable)(bool); //!< Enable operation
-    uint16_t (*Lock)(void); //!< Mutex aquire
-    void (*Unlock)(uint16_t); //!< Mutex release
-    bool (*Transmit)(uint8_t*, uint32_t); //!< Send message
-    uint8_t (*Receive)(void); //!< Receive message
-    bool (*RxIdle)(void); //!< Is the line is idle
-    uint16_t (*TxRest)(void); //!< Number of bytes to send left on DMA
-    bool (*TxDone)(void); //!< Last byte is out on USART
-} bsp_usart_desc_t;
-
-/// Device data
+    const uint8_t* Data; //!< Data to send
+    uint16_t Size; //!< Number of bytes
+    bsp_usart_sent_t Done; //!< Completion callback, 0 for none
+    volatile uint32_t Seq; //!< Commit sequence, queue position + 1 when filled in
+} bsp_usart_tx_t;
+
+/// Port instance data
 typedef struct
 {
     uint16_t Key; //!< Access key
-    uint16_t Ndt; //!< Previous data counter
-    uint16_t Cap; //!< Receive buffer capacity
-    uint8_t* Buf; //!< Receive buffer pointer
-    uint8_t* BufEnd; //!< Receive buffer end pointer
+    uint16_t Pos; //!< Read position in the receive buffer
+    bsp_usart_frame_t Frame; //!< Receive event callback, 0 when polled
+    bsp_usart_tx_t Queue[BSP_USART_TX_QUEUE]; //!< Transmit queue
+    volatile uint32_t Head; //!< Transmit queue next free position
+    volatile uint32_t Tail; //!< Transmit queue next position to send
+    volatile uint32_t Run; //!< The transmit stream is owned by the queue, 1 while an entry is sent
+    volatile uint32_t High; //!< Transmit queue high-water mark
+    bsp_usart_tx_t Cur; //!< Entry in transfer
 } bsp_usart_data_t;
 
-extern bsp_usart_data_t usart_3_inst;
+/// Received data in the receive buffer, the part up to the buffer end and the part after the wrap
+typedef struct
+{
+    const uint8_t* Data[2]; //!< Start of the parts
+    uint16_t Size[2]; //!< Size of the parts, the second is 0 without a wrap
+} bsp_usart_span_t;
+
+/// Port descriptor, a USART with its receive and transmit DMA streams and receive buffer.
+/// Intended as compile time constant, the accessors then fold to the hand-written register accesses.
+typedef struct bsp_usart_port_s
+{
+    const per_usart_t* const (* const Usart)(void); //!< USART
+    const per_dma_stream_t* const (* const RxDma)(void); //!< Receive DMA stream
+    const per_dma_selection_t* const (* const RxSel)(void); //!< Receive DMA stream-channel selection
+    const per_dma_stream_t* const (* const TxDma)(void); //!< Transmit DMA stream
+    const per_dma_selection_t* const (* const TxSel)(void); //!< Transmit DMA stream-channel selection
+    const per_usart_baud_t* const Rates; //!< Baud rate table of the USART clock, 0 to compute the divider at run time
+    const uint8_t RateNum; //!< Number of baud rates in the table
+    uint8_t* const Buf; //!< Receive buffer, circular DMA target
+    const uint16_t Cap; //!< Receive buffer capacity
+    bsp_usart_data_t* const Inst; //!< Instance data
+} bsp_usart_port_t;
+
+/// Single producer single consumer byte FIFO positions, free running, the buffer size is a power of two
+typedef struct
+{
+    volatile uint32_t Head; //!< Write position, only changed by the producer
+    volatile uint32_t Tail; //!< Read position, only changed by the consumer
+} bsp_usart_fifo_t;
+
+/// Interrupt driven port instance data
+typedef struct
+{
+    uint16_t Key; //!< Access key
+    bsp_usart_fifo_t Rx; //!< Receive FIFO, the interrupt produces
+    bsp_usart_fifo_t Tx; //!< Transmit FIFO, the interrupt consumes
+    volatile uint32_t Overrun; //!< Received bytes lost, FIFO full or USART overrun
+} bsp_usart_fifo_data_t;
+
+/// Interrupt driven port descriptor, a USART without DMA streams with a receive and a transmit FIFO.
+/// Intended as compile time constant like bsp_usart_port_t.
+typedef struct
+{
+    const per_usart_t* const (* const Usart)(void); //!< USART
+    const per_usart_baud_t* const Rates; //!< Baud rate table of the USART clock, 0 to compute the divider at run time
+    const uint8_t RateNum; //!< Number of baud rates in the table
+    uint8_t* const RxBuf; //!< Receive FIFO buffer
+    uint8_t* const TxBuf; //!< Transmit FIFO buffer
+    const uint16_t Mask; //!< FIFO buffer size - 1, the size is a power of two
+    bsp_usart_fifo_data_t* const Inst; //!< Instance data
+} bsp_usart_fifo_port_t;
+
+/// Number of baud rates in the board tables
+#define BSP_USART_RATES (8)
+
+extern const per_usart_baud_t bsp_usart_rates_apb1[BSP_USART_RATES];
+
+extern bsp_usart_data_t bsp_usart_3_inst;
+
+extern uint8_t bsp_usart_3_buf[BSP_USART_RX_SIZE];
+
+extern bsp_usart_fifo_data_t bsp_usart_4_inst;
 
-/// USART3 lock
-static per_inline uint16_t usart_3_lock(void)
+extern uint8_t bsp_usart_4_rx[BSP_USART_FIFO_SIZE];
+
+extern uint8_t bsp_usart_4_tx[BSP_USART_FIFO_SIZE];
+
+/// USART3 port, ST-LINK virtual COM port
+static per_inline const bsp_usart_port_t* const bsp_usart_3(void)
+{
+    static const bsp_usart_port_t port =
+    {
+        .Usart = per_usart_3,
+        .RxDma = bsp_dma_usart3_rx,
+        .RxSel = bsp_dma_usart3_rx_sel,
+        .TxDma = bsp_dma_usart3_tx,
+        .TxSel = bsp_dma_usart3_tx_sel,
+        .Rates = bsp_usart_rates_apb1,
+        .RateNum = BSP_USART_RATES,
+        .Buf = bsp_usart_3_buf,
+        .Cap = BSP_USART_RX_SIZE,
+        .Inst = &bsp_usart_3_inst,
+    };
+    return &port;
+}
+
+/// UART4 interrupt driven port
+static per_inline const bsp_usart_fifo_port_t* const bsp_usart_4(void)
+{
+    static const bsp_usart_fifo_port_t port =
+    {
+        .Usart = per_uart_4,
+        .Rates = bsp_usart_rates_apb1,
+        .RateNum = BSP_USART_RATES,
+        .RxBuf = bsp_usart_4_rx,
+        .TxBuf = bsp_usart_4_tx,
+        .Mask = BSP_USART_FIFO_SIZE - 1,
+        .Inst = &bsp_usart_4_inst,
+    };
+    return &port;
+}
+
+/// Port lock, returns the key or 0 when already locked
+static per_inline uint16_t bsp_usart_lock(const bsp_usart_port_t* const port)
 {
     uint16_t val = 0;
 
-    if (usart_3_inst.Key == 0) // not locked yet
+    if (port->Inst->Key == 0) // not locked yet
     {
-        val = bsp_dep_mut16_lock(&usart_3_inst.Key); // create key
+        val = bsp_dep_mut16_lock(&port->Inst->Key); // create key
     }
 
     return val;
 }
 
-/// USART3 unlock
-static per_inline void usart_3_unlock(uint16_t key)
+/// Port unlock
+static per_inline void bsp_usart_unlock(const bsp_usart_port_t* const port, uint16_t key)
 {
-    bsp_dep_mut16_unlock(&usart_3_inst.Key, key); // free mutex
+    bsp_dep_mut16_unlock(&port->Inst->Key, key); // free mutex
 }
 
-bool usart_3_setup(uint8_t* buffer, uint32_t capacity, uint32_t baudrate, per_usart_ps_e parity, per_usart_m_e word_length, per_usart_stop_e stop_bit);
-
-/// USART3 enable/disable
-static per_inline void usart_3_enable(bool en)
+/// Port the key fits the lock
+static per_inline bool bsp_usart_key(const bsp_usart_port_t* const port, uint16_t key)
 {
-    per_usart_set_ue(per_usart_3(), en);
+    const bool result = (port->Inst->Key == key);
+
+    if (!result)
+    {
+        per_log_err(port->Usart()->Err, PER_USART_LOCK_ERR, key);
+    }
+
+    return result;
 }
 
-bool usart_3_transmit(uint8_t* data, uint32_t size);
+bool bsp_usart_setup(const bsp_usart_port_t* const port, uint32_t baudrate, per_usart_ps_e parity, per_usart_m_e word_length, per_usart_stop_e stop_bit);
 
-uint8_t usart_3_receive(void);
+/// Port switch the baud rate to one of the table, no division
+static per_inline bool bsp_usart_set_rate(const bsp_usart_port_t* const port, uint32_t rate)
+{
+    return per_usart_set_baud_table(port->Usart(), port->Rates, port->RateNum, rate);
+}
 
-/// USART3 RX line is idle for at least one char
-static per_inline bool usart_3_rx_idle(void)
+/// Port enable/disable
+static per_inline void bsp_usart_enable(const bsp_usart_port_t* const port, bool en)
 {
-    return per_usart_idle(per_usart_3());
+    per_usart_set_ue(port->Usart(), en);
 }
 
-/// USART3 left over to transfer
-static per_inline uint16_t usart_3_tx_rest(void)
+/// Port send, the data must stay valid until bsp_usart_tx_done()
+static per_inline bool bsp_usart_transmit(const bsp_usart_port_t* const port, const uint8_t* data, uint16_t size)
 {
-    return per_dma_ndt(per_dma_1_stream_3());
+    const per_dma_stream_t* const dma = port->TxDma();
+    bool result = !per_dma_en(dma);
+
+    if (result)
+    {
+        (void)per_dma_stream_irq(dma); // Clear the flags of the previous transfer
+        per_dma_set_m0a(dma, (uint32_t)(uintptr_t)data);
+        per_dma_set_ndt(dma, size);
+        per_dma_set_en(dma, true);
+    }
+    else
+    {
+        per_log_err(port->Usart()->Err, PER_USART_BUSY_ERR, 0);
+    }
+
+    return result;
 }
 
-/// USART3 transfer completed
-static per_inline bool usart_3_tx_done(void)
+/// Port write position of the receive DMA stream in the receive buffer
+static per_inline uint16_t bsp_usart_rx_pos(const bsp_usart_port_t* const port)
 {
-    return per_dma_tcif(per_dma_1_stream_3());
+    const uint16_t pos = port->Cap - per_dma_ndt(port->RxDma());
+
+    return (pos < port->Cap) ? pos : 0; // NDTR reads 0 just before the circular reload
 }
 
-// Dummy functions to prevent null pointers
+/// Port received data in place, up to two parts of the receive buffer, without copy.
+/// Returns the total size. The data stays valid until bsp_usart_consume() or until the
+/// stream writes the receive buffer capacity of new bytes.
+static per_inline uint16_t bsp_usart_peek(const bsp_usart_port_t* const port, bsp_usart_span_t* span)
+{
+    const uint16_t rd = port->Inst->Pos;
+    const uint16_t wr = bsp_usart_rx_pos(port);
+
+    span->Data[0] = port->Buf + rd;
+    span->Data[1] = port->Buf;
 
-/// Dummy lock
-static per_inline uint16_t dummy_lock(void)
+    if (wr >= rd)
+    {
+        span->Size[0] = wr - rd;
+        span->Size[1] = 0;
+    }
+    else // Wrapped
+    {
+        span->Size[0] = port->Cap - rd;
+        span->Size[1] = wr;
+    }
+
+    return span->Size[0] + span->Size[1];
+}
+
+/// Port release size bytes of the received data, at most the total of bsp_usart_peek()
+static per_inline void bsp_usart_consume(const bsp_usart_port_t* const port, uint16_t size)
 {
-    return 0;
+    bsp_usart_data_t* const inst = port->Inst;
+    uint16_t pos = inst->Pos + size;
+
+    if (pos >= port->Cap)
+    {
+        pos -= port->Cap;
+    }
+
+    inst->Pos = pos;
 }
 
-/// Dummy unlock
-static per_inline void dummy_unlock(uint16_t key)
+/// Port receive byte, 0 when there is no new data
+static per_inline uint8_t bsp_usart_receive(const bsp_usart_port_t* const port)
 {
+    uint8_t result = 0;
+
+    if (port->Inst->Pos != bsp_usart_rx_pos(port))
+    {
+        result = port->Buf[port->Inst->Pos];
+        bsp_usart_consume(port, 1);
+    }
+
+    return result;
 }
 
-/// Dummy configure
-static per_inline bool dummy_setup(uint8_t* buffer, uint32_t capacity, uint32_t baudrate, per_usart_ps_e parity, per_usart_m_e word_length, per_usart_stop_e stop_bit)
+/// Port receive multiple bytes, returns the number of bytes copied to dest
+static per_inline uint16_t bsp_usart_receive_buf(const bsp_usart_port_t* const port, uint8_t* dest, uint16_t cap)
 {
-    return false;
+    bsp_usart_span_t span;
+    uint16_t size = 0;
+
+    if (bsp_usart_peek(port, &span) != 0)
+    {
+        uint16_t size1;
+
+        size = (span.Size[0] < cap) ? span.Size[0] : cap; // clip
+        size1 = (span.Size[1] < (cap - size)) ? span.Size[1] : (cap - size);
+        per_mem_copy(dest, span.Data[0], size); // Copy first part
+        per_mem_copy(dest + size, span.Data[1], size1); // Copy the part after the wrap
+        size += size1;
+        bsp_usart_consume(port, size);
+    }
+
+    return size;
 }
 
-/// Dummy enable/disable
-static per_inline void dummy_enable(bool en)
+bool bsp_usart_rx_events(const bsp_usart_port_t* const port, bsp_usart_frame_t frame);
+
+/// Port hand the received data to the receive event callback and consume it.
+/// A part that wraps is handed over as the part up to the buffer end (BSP_USART_EVENT_FULL) and the rest.
+static per_inline void bsp_usart_rx_event(const bsp_usart_port_t* const port, bsp_usart_event_e event)
 {
+    bsp_usart_data_t* const inst = port->Inst;
+    const uint16_t rd = inst->Pos;
+    const uint16_t wr = bsp_usart_rx_pos(port);
+
+    if (wr < rd) // Wrapped
+    {
+        inst->Frame(port, rd, port->Cap - rd, BSP_USART_EVENT_FULL);
+        inst->Pos = 0;
+
+        if (wr > 0)
+        {
+            inst->Frame(port, 0, wr, event);
+            inst->Pos = wr;
+        }
+    }
+    else if (wr > rd)
+    {
+        inst->Frame(port, rd, wr - rd, event);
+        inst->Pos = wr;
+    }
+}
+
+/// Port USART interrupt, the idle line event. Call from the USARTx_IRQHandler.
+static per_inline void bsp_usart_irq(const bsp_usart_port_t* const port)
+{
+    const per_usart_t* const usart = port->Usart();
+
+    if (per_usart_idle(usart))
+    {
+        (void)per_usart_dr(usart); // Status register then data register read clears the idle flag
+        bsp_usart_rx_event(port, BSP_USART_EVENT_IDLE);
+    }
 }
 
-/// Dummy send string
-static per_inline bool dummy_transmit(uint8_t* data, uint32_t size)
+/// Port receive DMA stream interrupt, the half and complete transfer events. Call from the DMAx_Streamy_IRQHandler.
+static per_inline void bsp_usart_rx_dma_irq(const bsp_usart_port_t* const port)
 {
-    return false;
+    const per_dma_flag_e flags = per_dma_stream_irq(port->RxDma());
+
+    if ((flags & PER_DMA_FLAG_TC) != 0)
+    {
+        bsp_usart_rx_event(port, BSP_USART_EVENT_FULL);
+    }
+    else if ((flags & PER_DMA_FLAG_HT) != 0)
+    {
+        bsp_usart_rx_event(port, BSP_USART_EVENT_HALF);
+    }
 }
 
-/// Dummy receive byte
-static per_inline uint8_t dummy_receive(void)
+/// Port start the next queued entry when the queue does not own the transmit stream yet. Lock-free, the queue
+/// owns the stream (Run) from the start of an entry until its transfer complete or error interrupt.
+static per_inline void bsp_usart_tx_next(const bsp_usart_port_t* const port)
 {
-    return (uint8_t)0;
+    bsp_usart_data_t* const inst = port->Inst;
+
+    while (true)
+    {
+        const uint32_t tail = inst->Tail;
+
+        if ((inst->Run != 0) || (inst->Queue[tail & (BSP_USART_TX_QUEUE - 1)].Seq != (tail + 1))) // Busy or nothing committed
+        {
+            return;
+        }
+
+        if ((per_dep_ldrex(&inst->Run) == 0) && (per_dep_strex(1, &inst->Run) == 0)) // Claim the stream
+        {
+            per_dep_barrier();
+
+            if ((inst->Tail == tail) && (inst->Queue[tail & (BSP_USART_TX_QUEUE - 1)].Seq == (tail + 1)))
+            {
+                const per_dma_stream_t* const dma = port->TxDma();
+
+                inst->Cur = inst->Queue[tail & (BSP_USART_TX_QUEUE - 1)];
+                inst->Tail = tail + 1; // Free the slot
+                per_dma_set_m0a(dma, (uint32_t)(uintptr_t)inst->Cur.Data);
+                per_dma_set_ndt(dma, inst->Cur.Size);
+                (void)per_dma_stream_irq(dma); // The stream flags must be clear before EN is set
+                per_dma_set_en(dma, true);
+                return;
+            }
+
+            inst->Run = 0; // An other owner started it meanwhile, check again
+            per_dep_barrier();
+        }
+    }
 }
 
-/// Dummy receive line idle
-static per_inline bool dummy_rx_idle(void)
+/// Port queue data to send, from any context. The entries are sent back to back, the transmit stream interrupt
+/// (bsp_usart_tx_dma_irq()) starts the next one. The data must stay valid until done is called. Returns false
+/// when the queue is full or size is 0, a stream of 0 data items never completes. Do not mix with bsp_usart_transmit()
+/// while entries are queued.
+static per_inline bool bsp_usart_send(const bsp_usart_port_t* const port, const uint8_t* data, uint16_t size, bsp_usart_sent_t done)
 {
+    bsp_usart_data_t* const inst = port->Inst;
+    bsp_usart_tx_t* slot;
+    uint32_t pos;
+    uint32_t high;
+
+    if (size == 0)
+    {
+        per_log_err(port->Usart()->Err, PER_USART_SIZE_ERR, 0);
+        return false;
+    }
+
+    do
+    {
+        pos = per_dep_ldrex(&inst->Head);
+
+        if ((pos - inst->Tail) >= BSP_USART_TX_QUEUE) // Full
+        {
+            per_log_err(port->Usart()->Err, PER_USART_BUSY_ERR, size);
+            return false;
+        }
+    }
+    while (per_dep_strex(pos + 1, &inst->Head) != 0); // Reserve the slot
+
+    slot = &inst->Queue[pos & (BSP_USART_TX_QUEUE - 1)];
+    slot->Data = data;
+    slot->Size = size;
+    slot->Done = done;
+    per_dep_barrier();
+    slot->Seq = pos + 1; // Commit
+
+    do
+    {
+        high = per_dep_ldrex(&inst->High);
+    }
+    while (per_dep_strex((((pos + 1) - inst->Tail) > high) ? ((pos + 1) - inst->Tail) : high, &inst->High) != 0);
+
+    per_dep_barrier();
+    bsp_usart_tx_next(port);
+
     return true;
 }
 
-/// Dummy left over to transfer
-static per_inline uint16_t dummy_tx_rest(void)
+/// Port transmit DMA stream interrupt, completes the sent entry and starts the next one first, back to back.
+/// A transfer or direct mode error is logged and ends the entry too, done is called and the queue goes on.
+/// Call from the DMAx_Streamy_IRQHandler of the transmit stream.
+static per_inline void bsp_usart_tx_dma_irq(const bsp_usart_port_t* const port)
 {
-    return (uint16_t)0;
+    bsp_usart_data_t* const inst = port->Inst;
+    const per_dma_stream_t* const dma = port->TxDma();
+    const per_dma_flag_e flags = per_dma_stream_irq(dma);
+
+    if (((flags & (PER_DMA_FLAG_TC | PER_DMA_FLAG_TE | PER_DMA_FLAG_DME)) != 0) && (inst->Run != 0))
+    {
+        const bsp_usart_tx_t cur = inst->Cur;
+
+        if ((flags & PER_DMA_FLAG_TE) != 0) // The hardware stopped the stream
+        {
+            per_log_err(dma->Err, PER_DMA_ERR_TRANSFER, cur.Size);
+        }
+
+        if ((flags & PER_DMA_FLAG_DME) != 0) // The stream keeps running, stop it before the next entry
+        {
+            per_log_err(dma->Err, PER_DMA_ERR_DIRECTMODE, cur.Size);
+            per_dma_set_en(dma, false);
+
+            while (per_dma_en(dma))
+            {
+            }
+        }
+
+        per_dep_barrier();
+        inst->Run = 0;
+        per_dep_barrier();
+        bsp_usart_tx_next(port);
+
+        if (cur.Done != 0)
+        {
+            cur.Done(port, cur.Data, cur.Size);
+        }
+    }
 }
 
-/// Dummy transfer completed
-static per_inline bool dummy_tx_done(void)
+/// Port number of transmit queue entries waiting, without the one in transfer
+static per_inline uint32_t bsp_usart_tx_depth(const bsp_usart_port_t* const port)
 {
-    return true;
+    return port->Inst->Head - port->Inst->Tail;
 }
 
-/// USART3 get pointer to the descriptor.
-static per_inline const bsp_usart_desc_t* bsp_usart_3(uint16_t key)
+/// Port transmit queue high-water mark, the most entries waiting since the last reset
+static per_inline uint32_t bsp_usart_tx_high(const bsp_usart_port_t* const port, bool reset)
 {
-    static const bsp_usart_desc_t usart_desc =
+    uint32_t high;
+
+    do
     {
-        .Lock = usart_3_lock,
-        .Unlock = usart_3_unlock,
-        .Setup = usart_3_setup,
-        .Enable = usart_3_enable,
-        .Transmit = usart_3_transmit,
-        .Receive = usart_3_receive,
-        .RxIdle = usart_3_rx_idle,
-        .TxRest = usart_3_tx_rest,
-        .TxDone = usart_3_tx_done,
-    };
-    /// Dummy descriptor. Prevents that all the caller functions require to check for null pointers.
-    static const bsp_usart_desc_t dummy_desc =
-    {
-        .Setup = dummy_setup,
-        .Enable = dummy_enable,
-        .Lock = dummy_lock,
-        .Unlock = dummy_unlock,
-        .Transmit = dummy_transmit,
-        .Receive = dummy_receive,
-        .RxIdle = dummy_rx_idle,
-        .TxRest = dummy_tx_rest,
-        .TxDone = dummy_tx_done,
-    };
-    const bsp_usart_desc_t* desc;
+        high = per_dep_ldrex(&port->Inst->High);
+    }
+    while (per_dep_strex(reset ? 0 : high, &port->Inst->High) != 0);
 
-    if (usart_3_inst.Key == key) // fit
+    return high;
+}
+
+bool bsp_usart_fifo_setup(const bsp_usart_fifo_port_t* const port, uint32_t baudrate, per_usart_ps_e parity, per_usart_m_e word_length, per_usart_stop_e stop_bit);
+
+/// Interrupt driven port interrupt, moves at most one received and one transmitted byte, without loops, so
+/// the cycle count is fixed. Call from the USARTx_IRQHandler.
+static per_inline void bsp_usart_fifo_irq(const bsp_usart_fifo_port_t* const port)
+{
+    const per_usart_t* const usart = port->Usart();
+    bsp_usart_fifo_data_t* const inst = port->Inst;
+    const uint_fast16_t sr = per_usart_sr(usart);
+
+    if ((sr & (PER_USART_SR_RXNE | PER_USART_SR_ORE)) != 0)
     {
-        desc = &usart_desc;
+        const uint32_t head = inst->Rx.Head;
+        const uint8_t data = (uint8_t)per_usart_dr(usart); // With the SR read above clears RXNE and ORE
+
+        if (((head - inst->Rx.Tail) > port->Mask) || ((sr & PER_USART_SR_ORE) != 0))
+        {
+            inst->Overrun++;
+        }
+
+        if ((head - inst->Rx.Tail) <= port->Mask)
+        {
+            port->RxBuf[head & port->Mask] = data;
+            per_dep_barrier();
+            inst->Rx.Head = head + 1;
+        }
     }
-    else // locked
+
+    if (((sr & PER_USART_SR_TXE) != 0) && per_usart_txeie(usart))
+    {
+        const uint32_t tail = inst->Tx.Tail;
+
+        if (tail != inst->Tx.Head)
+        {
+            (void)per_usart_set_dr(usart, port->TxBuf[tail & port->Mask]); // A byte is always within PER_USART_DR_MAX
+            per_dep_barrier();
+            inst->Tx.Tail = tail + 1;
+        }
+        else // Empty
+        {
+            per_usart_set_txeie(usart, false);
+        }
+    }
+}
+
+/// Interrupt driven port read up to size received bytes, returns the number of bytes read
+static per_inline uint32_t bsp_usart_fifo_read(const bsp_usart_fifo_port_t* const port, uint8_t* data, uint32_t size)
+{
+    bsp_usart_fifo_data_t* const inst = port->Inst;
+    const uint32_t tail = inst->Rx.Tail;
+    const uint32_t used = inst->Rx.Head - tail;
+    const uint32_t off = tail & port->Mask;
+    uint32_t size1;
+
+    if (size > used)
     {
-        desc = &dummy_desc;
-        per_log_err(PER_LOG_USART_3, PER_USART_LOCK_ERR, key);
+        size = used;
     }
 
-    return desc;
+    size1 = ((off + size) > (port->Mask + 1u)) ? ((port->Mask + 1u) - off) : size; // Up to the buffer end
+
+    per_dep_barrier();
+    per_mem_copy(data, port->RxBuf + off, size1);
+    per_mem_copy(data + size1, port->RxBuf, size - size1);
+    per_dep_barrier();
+    inst->Rx.Tail = tail + size; // Release
+
+    return size;
+}
+
+/// Interrupt driven port write up to size bytes to the transmit FIFO, returns the number of bytes accepted
+static per_inline uint32_t bsp_usart_fifo_write(const bsp_usart_fifo_port_t* const port, const uint8_t* data, uint32_t size)
+{
+    bsp_usart_fifo_data_t* const inst = port->Inst;
+    const uint32_t head = inst->Tx.Head;
+    const uint32_t free = (port->Mask + 1) - (head - inst->Tx.Tail);
+
+    if (size > free)
+    {
+        size = free;
+    }
+
+    if (size > 0)
+    {
+        const uint32_t off = head & port->Mask;
+        const uint32_t size1 = ((off + size) > (port->Mask + 1u)) ? ((port->Mask + 1u) - off) : size; // Up to the buffer end
+
+        per_mem_copy(port->TxBuf + off, data, size1);
+        per_mem_copy(port->TxBuf, data + size1, size - size1);
+        per_dep_barrier();
+        inst->Tx.Head = head + size; // Publish
+        per_usart_set_txeie(port->Usart(), true); // The interrupt sends
+    }
+
+    return size;
+}
+
+/// Interrupt driven port number of received bytes waiting
+static per_inline uint32_t bsp_usart_fifo_rx_used(const bsp_usart_fifo_port_t* const port)
+{
+    return port->Inst->Rx.Head - port->Inst->Rx.Tail;
+}
+
+/// Interrupt driven port free space in the transmit FIFO
+static per_inline uint32_t bsp_usart_fifo_tx_free(const bsp_usart_fifo_port_t* const port)
+{
+    return (port->Mask + 1) - (port->Inst->Tx.Head - port->Inst->Tx.Tail);
+}
+
+/// Port RX line is idle for at least one char
+static per_inline bool bsp_usart_rx_idle(const bsp_usart_port_t* const port)
+{
+    return per_usart_idle(port->Usart());
+}
+
+/// Port left over to transfer
+static per_inline uint16_t bsp_usart_tx_rest(const bsp_usart_port_t* const port)
+{
+    return per_dma_ndt(port->TxDma());
+}
+
+/// Port transfer completed
+static per_inline bool bsp_usart_tx_done(const bsp_usart_port_t* const port)
+{
+    return per_dma_tcif(port->TxDma());
 }
 
 #ifdef __cplusplus
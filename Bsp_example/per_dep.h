@@ -33,21 +33,52 @@ extern "C" {
 
 // All the external dependencies of the library
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
 /// Provide the correct in-line definition for the project here
-#define per_inline inline
+#define per_inline inline __attribute__((always_inline))
 
 /// Provide the correct LOG2 function
 #define per_log2(x) __builtin_ctz(x)
 
 /// Mark unsupported functions and generate a compile/link time error
+#ifdef PER_BENCH
+/// The benchmark probes pass run-time descriptors, the check can not be resolved at compile time
+void per_dep_err_unsupported(void);
+#else
 __attribute((error("\nError: function does not exists on this peripheral"))) void per_dep_err_unsupported(void);
+#endif
 
 /// Memory copy abstraction
 #define per_mem_copy(dest,src,n) memcpy(dest,src,n)
 
+#ifdef PER_HOST
+/// Exclusive monitor emulation on the host, value of the last exclusive load
+static __thread uint32_t per_dep_excl __attribute__((unused));
+
+/// Exclusive 32 bit load (LDREX) emulation
+#define per_dep_ldrex(addr) (per_dep_excl = *(addr))
+
+/// Exclusive 32 bit store (STREX) emulation, returns 0 on success, 1 when the value changed since the load
+#define per_dep_strex(val,addr) (uint32_t)!__atomic_compare_exchange_n((addr), &per_dep_excl, (val), false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+
+/// Memory barrier, all the memory accesses before are done before the ones after
+#define per_dep_barrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#include "cmsis_gcc.h" // for the LDREX and STREX
+
+/// Exclusive 32 bit load (LDREX)
+#define per_dep_ldrex(addr) __LDREXW(addr)
+
+/// Exclusive 32 bit store (STREX), returns 0 on success, 1 when the exclusive access was lost
+#define per_dep_strex(val,addr) __STREXW(val,addr)
+
+/// Memory barrier (DMB), all the memory accesses before are done before the ones after
+#define per_dep_barrier() __DMB()
+#endif
+
 #ifdef __cplusplus
 }
 #endif
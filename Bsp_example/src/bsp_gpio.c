@@ -37,4 +37,7 @@ void bsp_gpio_init(void)
 
     per_gpio_init_out_af(bsp_gpio_usart3_tx(), PER_GPIO_OTYPE_PUSH_PULL, PER_GPIO_OSPEED_MEDIUM, PER_GPIO_AF_USART3);
     per_gpio_init_in_af(bsp_gpio_usart3_rx(), PER_GPIO_PUPD_PULL_UP, PER_GPIO_AF_USART3);
+
+    per_gpio_init_out_af(bsp_gpio_uart4_tx(), PER_GPIO_OTYPE_PUSH_PULL, PER_GPIO_OSPEED_MEDIUM, PER_GPIO_AF_UART4);
+    per_gpio_init_in_af(bsp_gpio_uart4_rx(), PER_GPIO_PUPD_PULL_UP, PER_GPIO_AF_UART4);
 }
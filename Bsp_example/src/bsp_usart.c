@@ -29,13 +29,35 @@
 #include "per_rcc.h"
 
 #include "bsp_gpio.h"
+#include "bsp_rcc.h"
 
-bsp_usart_data_t usart_3_inst; ///< USART3 instance
+bsp_usart_data_t bsp_usart_3_inst; ///< USART3 instance
 
-/// Configure USART
-static per_inline bool usart_setup(const per_usart_t* const usart, uint32_t rate, per_usart_ps_e par, per_usart_m_e len, per_usart_stop_e stop)
+uint8_t bsp_usart_3_buf[BSP_USART_RX_SIZE]; ///< USART3 receive buffer
+
+bsp_usart_fifo_data_t bsp_usart_4_inst; ///< UART4 instance
+
+uint8_t bsp_usart_4_rx[BSP_USART_FIFO_SIZE]; ///< UART4 receive FIFO
+
+uint8_t bsp_usart_4_tx[BSP_USART_FIFO_SIZE]; ///< UART4 transmit FIFO
+
+/// Baud rates of the APB1 USARTs, computed at compile time
+const per_usart_baud_t bsp_usart_rates_apb1[BSP_USART_RATES] =
+{
+    PER_USART_BAUD(BSP_RCC_APB1_FREQ, 9600, false),
+    PER_USART_BAUD(BSP_RCC_APB1_FREQ, 19200, false),
+    PER_USART_BAUD(BSP_RCC_APB1_FREQ, 38400, false),
+    PER_USART_BAUD(BSP_RCC_APB1_FREQ, 57600, false),
+    PER_USART_BAUD(BSP_RCC_APB1_FREQ, 115200, false),
+    PER_USART_BAUD(BSP_RCC_APB1_FREQ, 230400, false),
+    PER_USART_BAUD(BSP_RCC_APB1_FREQ, 460800, false),
+    PER_USART_BAUD(BSP_RCC_APB1_FREQ, 921600, false),
+};
+
+/// Configure USART, from the baud rate table when there is one
+static bool usart_setup(const per_usart_t* const usart, const per_usart_baud_t* rates, uint_fast8_t num, uint32_t rate, per_usart_ps_e par, per_usart_m_e len, per_usart_stop_e stop)
 {
-    bool result = per_usart_set_baudrate(usart, rate);
+    bool result = (rates != 0) ? per_usart_set_baud_table(usart, rates, num, rate) : per_usart_set_baudrate(usart, rate);
 
     if (result)
     {
@@ -53,235 +75,141 @@ static per_inline bool usart_setup(const per_usart_t* const usart, uint32_t rate
     return result;
 }
 
-/// Disable DMA interrupts
-static void usart_dma_conf_irq_disable(const per_dma_stream_t* dma)
-{
-    per_dma_set_dmeie(dma, false);
-    per_dma_set_teie(dma, false);
-    per_dma_set_htie(dma, false);
-    per_dma_set_tcie(dma, false);
-}
-
-/// Clear errors DMA1 STREAM 1 for USART 3 RX
-static void usart_3_dma_1_stream_1_error_clear(void)
-{
-    const per_dma_stream_t* dma = per_dma_1_stream_1();
-    per_dma_clr_dmeif(dma);
-    per_dma_clr_feif(dma);
-    per_dma_clr_teif(dma);
-    per_dma_clr_chtif(dma);
-    per_dma_clr_ctcif(dma);
-}
-
-/// Clear errors DMA1 STREAM 3 for USART 3 TX
-static void usart_3_dma_1_stream_3_error_clear(void)
-{
-    const per_dma_stream_t* dma = per_dma_1_stream_3();
-    per_dma_clr_dmeif(dma);
-    per_dma_clr_cfeif(dma);
-    per_dma_clr_teif(dma);
-    per_dma_clr_chtif(dma);
-    per_dma_clr_ctcif(dma);
-}
-
-/// Configure DMA1 STREAM 1 for USART 3 RX multiple size registers
-static bool usart_3_dma_1_stream_1_setup_multi(const per_dma_stream_t* dma)
-{
-    return per_dma_set_dir(dma, PER_DMA_DIR_PER_TO_MEM) &&
-           per_dma_set_psize(dma, PER_DMA_SIZE_BYTE) &&
-           per_dma_set_msize(dma, PER_DMA_SIZE_BYTE) &&
-           per_dma_set_pl(dma, PER_DMA_PL_LOW) &&
-           per_dma_set_pburst(dma, PER_DMA_BURST_SINGlE) &&
-           per_dma_set_mburst(dma, PER_DMA_BURST_SINGlE) &&
-           per_dma_set_chsel(dma, &PER_DMA_1_STREAM_1_USART3_RX);
-}
-
-/// Configure DMA1 STREAM 1 for USART 3 RX
-static bool usart_3_dma_1_stream_1_setup(uint8_t* buf, uint32_t cap)
+/// Program a DMA stream with per_dma_apply(). The stream-channel selection of a port is only known at run time, it is
+/// checked here first so the compiler resolves the compile time check of per_dma_apply().
+static per_inline bool usart_dma_apply(const per_dma_stream_t* const dma, const per_dma_config_t* const config, uint16_t ndt, uint_fast32_t par, uint_fast32_t m0a, bool en)
 {
-    bsp_usart_data_t* inst = &usart_3_inst;
-    const per_dma_stream_t* dma = per_dma_1_stream_1();
-    bool result = !per_dma_en(dma);
+    bool result = (dma->Conf == config->Sel->Conf);
 
-    if (result)
+    if (!result)
     {
-        usart_dma_conf_irq_disable(dma);
-        result = usart_3_dma_1_stream_1_setup_multi(dma);
-
-        if (result)
-        {
-            per_dma_set_pfctrl(dma, false);
-            per_dma_set_circ(dma, true);
-            per_dma_set_pinc(dma, false);
-            per_dma_set_minc(dma, true);
-            per_dma_set_pincos(dma, false);
-            per_dma_set_dbm(dma, false);
-            per_dma_set_par(dma, (uint32_t)per_usart_addr_dr(per_usart_3()));
-            usart_3_dma_1_stream_1_error_clear();
-            per_dma_set_m0a(dma, (uint32_t)buf);
-            per_dma_set_ndt(dma, cap);
-            inst->Buf = buf;
-            inst->BufEnd = buf + cap;
-            inst->Cap = cap;
-            inst->Ndt = cap;
-            per_dma_set_en(dma, true);
-        }
+        per_log_err(dma->Err, PER_DMA_ERR_CONFIG, 0);
     }
     else
     {
-        per_log_err(PER_LOG_USART_3, PER_USART_BUSY_ERR, 0);
+        result = per_dma_apply(dma, config, ndt, par, m0a, en);
     }
 
     return result;
 }
 
-/// Configure DMA1 STREAM 3 for USART 3 TX multiple size registers
-static bool usart_3_dma_1_stream_3_setup_multi(const per_dma_stream_t* dma)
-{
-    return per_dma_set_dir(dma, PER_DMA_DIR_MEM_TO_PER) &&
-           per_dma_set_psize(dma, PER_DMA_SIZE_BYTE) &&
-           per_dma_set_msize(dma, PER_DMA_SIZE_BYTE) &&
-           per_dma_set_pl(dma, PER_DMA_PL_LOW) &&
-           per_dma_set_pburst(dma, PER_DMA_BURST_SINGlE) &&
-           per_dma_set_mburst(dma, PER_DMA_BURST_SINGlE) &&
-           per_dma_set_fth(dma, PER_DMA_FTH_ONE_QUARTER) &&
-           per_dma_set_chsel(dma, &PER_DMA_1_STREAM_3_USART3_TX);
-}
-
-/// Configure DMA1 STREAM 3 for USART 3 TX
-bool usart_3_dma_1_stream_3_setup(void)
+/// Configure and start the circular receive DMA stream
+static bool usart_dma_rx_setup(const bsp_usart_port_t* const port)
 {
-    const per_dma_stream_t* dma = per_dma_1_stream_3();
-    bool result = !per_dma_en(dma);
-
-    if (result)
+    const per_usart_t* const usart = port->Usart();
+    const per_dma_stream_t* const dma = port->RxDma();
+    const per_dma_config_t config =
     {
-        usart_dma_conf_irq_disable(dma);
-        result = usart_3_dma_1_stream_3_setup_multi(dma);
+        .Sel = port->RxSel(),
+        .Dir = PER_DMA_DIR_PER_TO_MEM,
+        .Psize = PER_DMA_SIZE_BYTE,
+        .Msize = PER_DMA_SIZE_BYTE,
+        .Minc = true,
+        .Circ = true,
+        .Pburst = PER_DMA_BURST_SINGlE,
+        .Mburst = PER_DMA_BURST_SINGlE,
+        .Pl = PER_DMA_PL_LOW,
+    };
+    const bool result = usart_dma_apply(dma, &config, port->Cap, (uint32_t)(uintptr_t)per_usart_addr_dr(usart), (uint32_t)(uintptr_t)port->Buf, true);
 
-        if (result)
-        {
-            per_dma_set_pfctrl(dma, false);
-            per_dma_set_circ(dma, false);
-            per_dma_set_pinc(dma, false);
-            per_dma_set_minc(dma, true);
-            per_dma_set_pincos(dma, false);
-            per_dma_set_dbm(dma, false);
-            per_dma_set_par(dma, (uint32_t)per_usart_addr_dr(per_usart_3()));
-            per_dma_set_feie(dma, false);
-            per_dma_set_dmdis(dma, true);
-        }
-    }
-    else
+    if (result)
     {
-        per_log_err(PER_LOG_USART_3, PER_USART_BUSY_ERR, 0);
+        port->Inst->Pos = 0;
     }
 
     return result;
 }
 
-/// USART3 configure
-bool usart_3_setup(uint8_t* buffer, uint32_t capacity, uint32_t rate, per_usart_ps_e par, per_usart_m_e len, per_usart_stop_e stop)
+/// Configure the transmit DMA stream, bsp_usart_transmit() starts it
+static bool usart_dma_tx_setup(const bsp_usart_port_t* const port)
 {
-    per_usart_set_dmat(per_usart_3(), true);
-    per_usart_set_dmar(per_usart_3(), true);
-    return usart_3_dma_1_stream_1_setup(buffer, capacity) && // RX
-           usart_3_dma_1_stream_3_setup() && // TX
-           usart_setup(per_usart_3(), rate, par, len, stop);
+    const per_usart_t* const usart = port->Usart();
+    const per_dma_stream_t* const dma = port->TxDma();
+    const per_dma_config_t config =
+    {
+        .Sel = port->TxSel(),
+        .Dir = PER_DMA_DIR_MEM_TO_PER,
+        .Psize = PER_DMA_SIZE_BYTE,
+        .Msize = PER_DMA_SIZE_BYTE,
+        .Minc = true,
+        .Pburst = PER_DMA_BURST_SINGlE,
+        .Mburst = PER_DMA_BURST_SINGlE,
+        .Pl = PER_DMA_PL_LOW,
+        .Tcie = true, // For bsp_usart_tx_dma_irq(), it is only called when the stream interrupt is enabled in the NVIC
+        .Teie = true, // A stopped stream ends the entry as well, the queue does not wait for a TC forever
+        .Dmeie = true,
+        .Dmdis = true,
+        .Fth = PER_DMA_FTH_ONE_QUARTER,
+    };
+
+    return usart_dma_apply(dma, &config, 0, (uint32_t)(uintptr_t)per_usart_addr_dr(usart), 0, false);
 }
 
-/// USART3 send string
-bool usart_3_transmit(uint8_t* data, uint32_t size)
+/// Port configure, one function for all ports as it is not on the hot path
+bool bsp_usart_setup(const bsp_usart_port_t* const port, uint32_t rate, per_usart_ps_e par, per_usart_m_e len, per_usart_stop_e stop)
 {
-    const per_dma_stream_t* dma = per_dma_1_stream_3();
-    bool result = !per_dma_en(dma);
+    const per_usart_t* const usart = port->Usart();
+    bool result;
 
-    if (result)
-    {
-        usart_3_dma_1_stream_3_error_clear();
-        per_dma_set_m0a(dma, (uint32_t)data);
-        per_dma_set_ndt(dma, size);
-        per_dma_set_en(dma, true);
-    }
-    else
+    per_usart_set_dmat(usart, true);
+    per_usart_set_dmar(usart, true);
+    result = usart_dma_rx_setup(port); // RX
+
+    if (result && !(usart_dma_tx_setup(port) && // TX
+                    usart_setup(usart, port->Rates, port->RateNum, rate, par, len, stop)))
     {
-        per_log_err(PER_LOG_USART_3, PER_USART_BUSY_ERR, 0);
+        per_dma_set_en(port->RxDma(), false); // Do not leave the circular receive stream running
+        result = false;
     }
 
     return result;
 }
 
-/// USART3 receive byte
-uint8_t usart_3_receive(void)
+/// Port start or stop (frame 0) the interrupt driven reception. The received data is handed to frame
+/// on the USART idle line and the receive DMA half and complete transfer interrupts. The USART and the
+/// receive DMA stream interrupts must have the same priority, bsp_usart_irq() and bsp_usart_rx_dma_irq()
+/// do not preempt each other. Received data not consumed yet is dropped.
+bool bsp_usart_rx_events(const bsp_usart_port_t* const port, bsp_usart_frame_t frame)
 {
-    const per_dma_stream_t* dma = per_dma_1_stream_1();
-    uint16_t ndt = per_dma_ndt(dma);
-    uint8_t result = 0;
+    const per_usart_t* const usart = port->Usart();
+    const per_dma_stream_t* const dma = port->RxDma();
+    const bool en = (frame != 0);
+    bool result = per_dma_en(dma);
 
-    if (ndt != usart_3_inst.Ndt)
+    if (result)
     {
-        result = *(usart_3_inst.Buf + usart_3_inst.Cap - usart_3_inst.Ndt);
-
-        if (usart_3_inst.Ndt > 0)
-        {
-            usart_3_inst.Ndt--;
-        }
-        else
-        {
-            usart_3_inst.Ndt = usart_3_inst.Cap;
-        }
+        per_usart_set_idleie(usart, false);
+        per_dma_set_htie(dma, false);
+        per_dma_set_tcie(dma, false);
+        port->Inst->Frame = frame;
+        port->Inst->Pos = bsp_usart_rx_pos(port);
+        (void)per_usart_idle(usart);
+        (void)per_usart_dr(usart); // Clear an old idle flag
+        (void)per_dma_stream_irq(dma); // Clear the old flags
+        per_dma_set_htie(dma, en);
+        per_dma_set_tcie(dma, en);
+        per_usart_set_idleie(usart, en);
+    }
+    else // Not set up
+    {
+        per_log_err(dma->Err, PER_DMA_ERR_CONFIG, 0);
     }
 
     return result;
 }
 
-/// USART3 receive multiple bytes
-uint16_t usart_3_receive2(uint8_t* dest, uint16_t cap)
+/// Interrupt driven port configure, the FIFOs are emptied and the receive interrupt is enabled
+bool bsp_usart_fifo_setup(const bsp_usart_fifo_port_t* const port, uint32_t rate, per_usart_ps_e par, per_usart_m_e len, per_usart_stop_e stop)
 {
-    const per_dma_stream_t* dma = per_dma_1_stream_1();
-    uint16_t ndt = per_dma_ndt(dma);
-    int32_t dev = usart_3_inst.Ndt - ndt;
-    uint16_t size = 0;
-
-    if (dev != 0) // new data
-    {
-        uint16_t size1 = 0;
-
-        if (dev < 0)
-        {
-            size1 = usart_3_inst.Ndt;
-
-            if (size1 > cap)
-            {
-                size1 = cap; // clip
-            }
-
-            per_mem_copy(dest, usart_3_inst.BufEnd - usart_3_inst.Ndt, size1); // Copy first part
-            usart_3_inst.Ndt -= size1;
+    const per_usart_t* const usart = port->Usart();
+    bsp_usart_fifo_data_t* const inst = port->Inst;
 
-            if (usart_3_inst.Ndt == 0) // Rest
-            {
-                cap -= size1;
-                usart_3_inst.Ndt = usart_3_inst.Cap;
-                dev = usart_3_inst.Ndt - ndt;
-            }
-        }
-
-        if (dev > 0)
-        {
-            size = (uint16_t)dev;
-
-            if (size > cap)
-            {
-                size = cap; // clip
-            }
-
-            per_mem_copy(dest, usart_3_inst.BufEnd - usart_3_inst.Ndt, size); // Copy all
-            usart_3_inst.Ndt -= size;
-        }
-
-        size += size1; // Total
-    }
+    per_usart_set_txeie(usart, false);
+    per_usart_set_rxneie(usart, false);
+    inst->Rx.Tail = inst->Rx.Head;
+    inst->Tx.Head = inst->Tx.Tail;
+    inst->Overrun = 0;
+    per_usart_set_rxneie(usart, true);
 
-    return size;
+    return usart_setup(usart, port->Rates, port->RateNum, rate, par, len, stop);
 }
@@ -1009,7 +1009,7 @@ static per_inline uint_fast16_t per_adc_data(const per_adc_t* const adc)
 }
 
 /// ADC address Data value register address
-static per_inline volatile uint_fast16_t* per_usart_addr_data(const per_adc_t* const adc)
+static per_inline volatile per_bit_fast16_t* per_usart_addr_data(const per_adc_t* const adc)
 {
     return &PER_BIT_BIT_BAND_TO_REG(&adc->Per->D)->Reg16;
 }
@@ -33,27 +33,37 @@ extern "C" {
 
 #include "per_addr.h"
 #include "per_dep.h"
+#include "per_log_f4.h"
 
 /// BIT error enumeration
 typedef enum
 {
     PER_BIT_ERR_OK = 0, ///< No error
     PER_BIT_ERR_SET, ///< Set and check corrupted
+    PER_BIT_ERR_TRANS, ///< Transaction register capacity exceeded
 } per_bit_error_e;
 
+#ifdef PER_HOST
+typedef uint32_t per_bit_fast8_t;  ///< 8 bit access type, 32 bit like the fast type of the target
+typedef uint32_t per_bit_fast16_t; ///< 16 bit access type, 32 bit like the fast type of the target
+#else
+typedef uint_fast8_t per_bit_fast8_t;   ///< 8 bit access type
+typedef uint_fast16_t per_bit_fast16_t; ///< 16 bit access type
+#endif
+
 /// One peripheral bitband bit, size is 32 bit in the bitband area
 typedef union
 {
-    volatile uint_fast8_t Bit8;   ///< One register bit presentation in the bitband region
-    volatile uint_fast16_t Bit16; ///< One register bit presentation in the bitband region 16 bit access
+    volatile per_bit_fast8_t Bit8;   ///< One register bit presentation in the bitband region
+    volatile per_bit_fast16_t Bit16; ///< One register bit presentation in the bitband region 16 bit access
     volatile uint32_t Bit32; ///< One register bit presentation in the bitband region 32 bit access
 } per_bit_bitband_t;
 
 /// One peripheral register, size is 32 bit in the peripheral register area
 typedef union
 {
-    volatile uint_fast8_t Reg8;   ///< 8 bit value
-    volatile uint_fast16_t Reg16; ///< 16 bit value
+    volatile per_bit_fast8_t Reg8;   ///< 8 bit value
+    volatile per_bit_fast16_t Reg16; ///< 16 bit value
     volatile uint32_t Reg32; ///< 32 bit value
 } per_bit_register_t;
 
@@ -75,8 +85,11 @@ typedef union
 /// Filter to leave bit offset
 #define PER_BIT_MAX(SIZE) ((uint32_t)((1 << SIZE) - 1))
 
+/// Filter to leave bit offset, valid for all sizes up to 32 bits
+#define PER_BIT_MAX32(SIZE) ((uint32_t)(UINT32_MAX >> (PER_BIT_REG_BITS - (SIZE))))
+
 /// Bit offset mask
-#define PER_BIT_BB_BIT_MASK (~PER_BIT_MAX(PER_BIT_BB_BIT_SHIFT))
+#define PER_BIT_BB_BIT_MASK (~(uintptr_t)PER_BIT_MAX(PER_BIT_BB_BIT_SHIFT))
 
 /// Get a bit band address from a ram bit in the ram1 alias area
 #define RAM_BIT_BAND_DATA1(REG,BIT) ((per_bit_bitband_t*)(SRAM1_BB_BASE | (((uintptr_t)REG - SRAM1_BASE) << PER_BIT_BB_REG_SHIFT) | ((uintptr_t)BIT << PER_BIT_BB_BIT_SHIFT)))
@@ -96,9 +109,28 @@ typedef union
 /// Get the contents of a part of a register. Maximum 16 bits
 #define PER_BIT_BITS_GET(PBAND,SIZE) ((uint_fast16_t)(PER_BIT_BIT_BAND_TO_REG(PBAND)->Reg32 >> PER_BIT_SHIFT(PBAND)) & PER_BIT_MAX(SIZE))
 
+/// Get the contents of a part of a register. Maximum 32 bits
+#define PER_BIT_BITS_GET32(PBAND,SIZE) ((uint32_t)(PER_BIT_BIT_BAND_TO_REG(PBAND)->Reg32 >> PER_BIT_SHIFT(PBAND)) & PER_BIT_MAX32(SIZE))
+
 /// Filter to mask leave one bit
 #define PER_BIT_REG_MASK_BIT(PBAND) ((uint32_t)(1 << PER_BIT_SHIFT(PBAND)))
 
+#ifdef PER_HOST
+/// Get one bit band bit, the host emulates it on the backing register
+#define PER_BIT_BB_GET(PBAND) ((PER_BIT_BIT_BAND_TO_REG(PBAND)->Reg32 >> PER_BIT_SHIFT(PBAND)) & PER_BIT_1)
+
+/// Set one bit band bit, the host emulates it with an atomic read-modify-write of the backing register
+#define PER_BIT_BB_SET(PBAND,VAL) ((VAL) ?\
+    __atomic_fetch_or(&PER_BIT_BIT_BAND_TO_REG(PBAND)->Reg32, PER_BIT_REG_MASK_BIT(PBAND), __ATOMIC_SEQ_CST) :\
+    __atomic_fetch_and(&PER_BIT_BIT_BAND_TO_REG(PBAND)->Reg32, ~PER_BIT_REG_MASK_BIT(PBAND), __ATOMIC_SEQ_CST))
+#else
+/// Get one bit band bit
+#define PER_BIT_BB_GET(PBAND) ((PBAND)->Bit8)
+
+/// Set one bit band bit
+#define PER_BIT_BB_SET(PBAND,VAL) ((PBAND)->Bit8 = (VAL))
+#endif
+
 
 /// Peripheral Read-write bit
 typedef struct
@@ -109,13 +141,13 @@ typedef struct
 /// One read and write bit get
 static per_inline bool per_bit_rw1(const per_bit_rw1_t* self)
 {
-    return self->Rw.Bit8 != PER_BIT_0;
+    return PER_BIT_BB_GET(&self->Rw) != PER_BIT_0;
 }
 
 /// One read and write bit set
 static per_inline void per_bit_rw1_set(per_bit_rw1_t* self, const bool val)
 {
-    self->Rw.Bit8 = (uint_fast8_t)val; // Cast is fast
+    PER_BIT_BB_SET(&self->Rw, (uint_fast8_t)val); // Cast is fast
 }
 
 /// One read and write bit mask
@@ -138,14 +170,14 @@ typedef struct
 /// One read and set bit get
 static per_inline bool per_bit_rs1(const per_bit_rs1_t* self)
 {
-    return self->Rs.Bit8 != PER_BIT_0;
+    return PER_BIT_BB_GET(&self->Rs) != PER_BIT_0;
 }
 
 /// One read and set bit set
 /// Set by writing one
 static per_inline void per_bit_rs1_set(per_bit_rs1_t* self)
 {
-    self->Rs.Bit8 = PER_BIT_1;
+    PER_BIT_BB_SET(&self->Rs, PER_BIT_1);
 }
 
 /// Peripheral Read-clear 0 bit
@@ -157,7 +189,7 @@ typedef struct
 /// One read and clear bit get
 static per_inline bool per_bit_rc1_w0(const per_bit_rc1_w0_t* self)
 {
-    return self->Rc.Bit8 != PER_BIT_0;
+    return PER_BIT_BB_GET(&self->Rc) != PER_BIT_0;
 }
 
 /// One read and clear bit read and clear
@@ -183,7 +215,7 @@ typedef struct
 /// One read and clear bit get
 static per_inline bool per_bit_rc1_w1(const per_bit_rc1_w1_t* self)
 {
-    return self->Rc.Bit8 != PER_BIT_0;
+    return PER_BIT_BB_GET(&self->Rc) != PER_BIT_0;
 }
 
 /// One read and clear bit read and clear
@@ -209,7 +241,7 @@ typedef struct
 /// One read bit get
 static per_inline bool per_bit_r1(const per_bit_r1_t* self)
 {
-    return self->R.Bit8 != PER_BIT_0;
+    return PER_BIT_BB_GET(&self->R) != PER_BIT_0;
 }
 
 /// Peripheral Write-only bit
@@ -221,7 +253,7 @@ typedef struct
 /// One write bit set
 static per_inline void per_bit_w1_set(per_bit_w1_t* self, const bool val)
 {
-    self->W.Bit8 = (uint_fast8_t)val; // Cast is fast
+    PER_BIT_BB_SET(&self->W, (uint_fast8_t)val); // Cast is fast
 }
 
 /// Peripheral Reserved bit
@@ -233,13 +265,138 @@ typedef struct
 bool per_bit_set_bits(per_bit_bitband_t* addr, const uint_fast8_t size, const uint_fast16_t val);
 bool per_bit_set_bits_check(per_bit_bitband_t* addr, const uint_fast8_t size, const uint_fast16_t val);
 
+/// Minimum field size that xxx_set() writes with one exclusive read-modify-write instead of a bitband loop
+/// A bitband bit is about three instructions, the exclusive write about nine plus the retry branch, so the
+/// default 4 keeps the 2 and 3 bit fields on bitband and writes wider ones (USART DIV_Fraction and
+/// DIV_Mantissa, RCC PLLN, ...) at once. The SET_SIZES comparison of tools/per_bench.py measures both paths
+/// with the target compiler. Define it as 17 for bitband everywhere, xxx_set_excl() forces the exclusive path.
+#ifndef PER_BIT_SET_EXCL_SIZE
+#define PER_BIT_SET_EXCL_SIZE ((uint_fast8_t)4)
+#endif
+
+/// Set the contents of a number of bits with one exclusive (LDREX/STREX) read-modify-write
+/// Interrupt safe, an interrupt between the load and the store makes the store fail and it is retried.
+/// The register does not pass through intermediate values and the duration does not depend on the size.
+static per_inline bool per_bit_set_bits_excl(per_bit_bitband_t* addr, const uint_fast8_t size, const uint32_t val)
+{
+    volatile uint32_t* const reg = &PER_BIT_BIT_BAND_TO_REG(addr)->Reg32; // Register pointer
+    const uint32_t mask = PER_BIT_MAX32(size) << PER_BIT_SHIFT(addr); // Field mask
+    const uint32_t bits = (val << PER_BIT_SHIFT(addr)) & mask; // Field value
+    uint32_t reg_val;
+
+    do
+    {
+        reg_val = (per_dep_ldrex(reg) & ~mask) | bits;
+    }
+    while (per_dep_strex(reg_val, reg) != 0);
+
+    return true;
+}
+
+/// Maximum number of registers in one transaction
+#ifndef PER_BIT_TRANS_MAX
+#define PER_BIT_TRANS_MAX (4)
+#endif
+
+/// One register in a transaction
+typedef struct
+{
+    volatile uint32_t* Reg; ///< Register pointer
+    uint32_t Mask; ///< Written bits
+    uint32_t Val; ///< Value of the written bits
+} per_bit_trans_reg_t;
+
+/// Register transaction, collects field writes in shadow words and writes each register once
+typedef struct
+{
+    uint_fast8_t Count; ///< Number of registers in use
+    per_bit_trans_reg_t Reg[PER_BIT_TRANS_MAX]; ///< Shadow registers
+} per_bit_trans_t;
+
+/// Transaction start, no registers touched yet
+static per_inline void per_bit_trans_begin(per_bit_trans_t* trans)
+{
+    trans->Count = 0;
+}
+
+/// Transaction add a field write to the shadow word of its register
+/// addr: any bitband address in the register
+static per_inline bool per_bit_trans_set(per_bit_trans_t* trans, const void* addr, uint32_t mask, uint32_t val)
+{
+    volatile uint32_t* const reg = &PER_BIT_BIT_BAND_TO_REG(addr)->Reg32; // Register pointer
+    uint_fast8_t i = 0;
+
+    while ((i < trans->Count) && (trans->Reg[i].Reg != reg))
+    {
+        ++i;
+    }
+
+    if (i >= PER_BIT_TRANS_MAX)
+    {
+        per_log_err(PER_LOG_BITBAND, PER_BIT_ERR_TRANS, (uint_fast32_t)(uintptr_t)reg); // Address is error value
+        return false;
+    }
+
+    if (i == trans->Count) // New register
+    {
+        trans->Reg[i].Reg = reg;
+        trans->Reg[i].Mask = 0;
+        trans->Reg[i].Val = 0;
+        trans->Count = i + 1;
+    }
+
+    trans->Reg[i].Mask |= mask;
+    trans->Reg[i].Val = (trans->Reg[i].Val & ~mask) | (val & mask);
+
+    return true;
+}
+
+/// Transaction write the touched registers, one store per register
+/// Completely written registers are stored, partially written registers get one exclusive read-modify-write
+static per_inline void per_bit_trans_commit(per_bit_trans_t* trans)
+{
+    const per_bit_trans_reg_t* shadow = &trans->Reg[0];
+    const per_bit_trans_reg_t* const end = shadow + trans->Count;
+
+    while (shadow < end)
+    {
+        if (shadow->Mask == UINT32_MAX)
+        {
+            *shadow->Reg = shadow->Val;
+        }
+        else
+        {
+            uint32_t reg_val;
+
+            do
+            {
+                reg_val = (per_dep_ldrex(shadow->Reg) & ~shadow->Mask) | shadow->Val;
+            }
+            while (per_dep_strex(reg_val, shadow->Reg) != 0);
+        }
+
+        ++shadow;
+    }
+
+    trans->Count = 0;
+}
+
+/// One read and write bit set in a transaction
+static per_inline bool per_bit_rw1_trans_set(per_bit_trans_t* trans, per_bit_rw1_t* self, const bool val)
+{
+    return per_bit_trans_set(trans, self, per_bit_rw1_mask(self), (uint32_t)val << per_bit_rw1_shift(self));
+}
+
 /// Multiple bit xxx_t read and write 16 bits maximum
 #define PER_BIT_READ_WRITE(NAME,SIZE)  typedef struct { per_bit_bitband_t Rw[SIZE]; } NAME##_t;\
     static per_inline uint_fast16_t NAME (const NAME##_t* self) {return PER_BIT_BITS_GET(self, SIZE);};\
-    static per_inline bool NAME##_set (NAME##_t* self, uint_fast16_t value) {return per_bit_set_bits(&self->Rw[0], SIZE, value);}\
+    static per_inline bool NAME##_set (NAME##_t* self, uint_fast16_t value) {return (SIZE >= PER_BIT_SET_EXCL_SIZE) ?\
+        per_bit_set_bits_excl(&self->Rw[0], SIZE, value) : per_bit_set_bits(&self->Rw[0], SIZE, value);}\
+    static per_inline bool NAME##_set_excl (NAME##_t* self, uint_fast16_t value) {return per_bit_set_bits_excl(&self->Rw[0], SIZE, value);}\
     static per_inline uint32_t NAME##_max (void) {return PER_BIT_MAX(SIZE);};\
     static per_inline uint_fast8_t NAME##_shift (const NAME##_t* self) {return PER_BIT_SHIFT(self);};\
-    static per_inline uint32_t NAME##_mask (const NAME##_t* self) {return PER_BIT_MAX(SIZE) << PER_BIT_SHIFT(self);};
+    static per_inline uint32_t NAME##_mask (const NAME##_t* self) {return PER_BIT_MAX(SIZE) << PER_BIT_SHIFT(self);};\
+    static per_inline bool NAME##_trans_set (per_bit_trans_t* trans, NAME##_t* self, uint_fast16_t value) {return per_bit_trans_set(trans, self, NAME##_mask(self), (uint32_t)value << NAME##_shift(self));}
 
 PER_BIT_READ_WRITE(per_bit_rw2, 2); ///< per_bit_rw2_t 2 bit peripheral read and write
 PER_BIT_READ_WRITE(per_bit_rw3, 3); ///< per_bit_rw3_t 3 bit peripheral read and write
@@ -257,6 +414,34 @@ PER_BIT_READ_WRITE(per_bit_rw14, 14); ///< per_bit_rw14_t 14 bit peripheral read
 PER_BIT_READ_WRITE(per_bit_rw15, 15); ///< per_bit_rw15_t 15 bit peripheral read and write
 PER_BIT_READ_WRITE(per_bit_rw16, 16); ///< per_bit_rw16_t 16 bit peripheral read and write
 
+/// Multiple bit xxx_t read and write 17 up to 32 bits
+/// One 32 bit register access with a compile time mask and shift, a 32 bit field is written with one store
+#define PER_BIT_READ_WRITE_WIDE(NAME,SIZE)  typedef struct { per_bit_bitband_t Rw[SIZE]; } NAME##_t;\
+    static per_inline uint32_t NAME (const NAME##_t* self) {return PER_BIT_BITS_GET32(self, SIZE);};\
+    static per_inline bool NAME##_set (NAME##_t* self, uint32_t value) {if (SIZE == PER_BIT_REG_BITS) {PER_BIT_BIT_BAND_TO_REG(self)->Reg32 = value; return true;}\
+        return per_bit_set_bits_excl(&self->Rw[0], SIZE, value);}\
+    static per_inline uint32_t NAME##_max (void) {return PER_BIT_MAX32(SIZE);};\
+    static per_inline uint_fast8_t NAME##_shift (const NAME##_t* self) {return PER_BIT_SHIFT(self);};\
+    static per_inline uint32_t NAME##_mask (const NAME##_t* self) {return PER_BIT_MAX32(SIZE) << PER_BIT_SHIFT(self);};\
+    static per_inline bool NAME##_trans_set (per_bit_trans_t* trans, NAME##_t* self, uint32_t value) {return per_bit_trans_set(trans, self, NAME##_mask(self), value << NAME##_shift(self));}
+
+PER_BIT_READ_WRITE_WIDE(per_bit_rw17, 17); ///< per_bit_rw17_t 17 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw18, 18); ///< per_bit_rw18_t 18 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw19, 19); ///< per_bit_rw19_t 19 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw20, 20); ///< per_bit_rw20_t 20 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw21, 21); ///< per_bit_rw21_t 21 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw22, 22); ///< per_bit_rw22_t 22 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw23, 23); ///< per_bit_rw23_t 23 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw24, 24); ///< per_bit_rw24_t 24 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw25, 25); ///< per_bit_rw25_t 25 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw26, 26); ///< per_bit_rw26_t 26 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw27, 27); ///< per_bit_rw27_t 27 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw28, 28); ///< per_bit_rw28_t 28 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw29, 29); ///< per_bit_rw29_t 29 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw30, 30); ///< per_bit_rw30_t 30 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw31, 31); ///< per_bit_rw31_t 31 bit peripheral read and write
+PER_BIT_READ_WRITE_WIDE(per_bit_rw32, 32); ///< per_bit_rw32_t 32 bit peripheral read and write
+
 /// Multiple bit xxx_t read only
 #define PER_BIT_READ(NAME,SIZE)  typedef struct { volatile const uint32_t BIT[SIZE]; } NAME##_t;\
     static per_inline uint_fast16_t NAME (const NAME##_t* self) {return PER_BIT_BITS_GET(self, SIZE);}
@@ -277,6 +462,27 @@ PER_BIT_READ(per_bit_r14, 14); ///< per_bit_r14_t 14 bit peripheral read only
 PER_BIT_READ(per_bit_r15, 15); ///< per_bit_r15_t 15 bit peripheral read only
 PER_BIT_READ(per_bit_r16, 16); ///< per_bit_r16_t 16 bit peripheral read only
 
+/// Multiple bit xxx_t read only 17 up to 32 bits
+#define PER_BIT_READ_WIDE(NAME,SIZE)  typedef struct { volatile const uint32_t BIT[SIZE]; } NAME##_t;\
+    static per_inline uint32_t NAME (const NAME##_t* self) {return PER_BIT_BITS_GET32(self, SIZE);}
+
+PER_BIT_READ_WIDE(per_bit_r17, 17); ///< per_bit_r17_t 17 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r18, 18); ///< per_bit_r18_t 18 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r19, 19); ///< per_bit_r19_t 19 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r20, 20); ///< per_bit_r20_t 20 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r21, 21); ///< per_bit_r21_t 21 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r22, 22); ///< per_bit_r22_t 22 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r23, 23); ///< per_bit_r23_t 23 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r24, 24); ///< per_bit_r24_t 24 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r25, 25); ///< per_bit_r25_t 25 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r26, 26); ///< per_bit_r26_t 26 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r27, 27); ///< per_bit_r27_t 27 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r28, 28); ///< per_bit_r28_t 28 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r29, 29); ///< per_bit_r29_t 29 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r30, 30); ///< per_bit_r30_t 30 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r31, 31); ///< per_bit_r31_t 31 bit peripheral read only
+PER_BIT_READ_WIDE(per_bit_r32, 32); ///< per_bit_r32_t 32 bit peripheral read only
+
 /// Multiple bit xxx_t no actions, reserved
 #define PER_BIT_NONE(NAME,SIZE)  typedef struct { per_bit_bitband_t N[SIZE]; } NAME##_t;
 
@@ -366,6 +572,12 @@ static per_inline void per_bit_rw32_reg_set(per_bit_rw32_reg_t* self, const uint
     PER_BIT_BIT_BAND_TO_REG(self)->Reg32 = val;
 }
 
+/// Peripheral register 32 bit write in a transaction
+static per_inline bool per_bit_rw32_reg_trans_set(per_bit_trans_t* trans, per_bit_rw32_reg_t* self, const uint32_t val)
+{
+    return per_bit_trans_set(trans, self, UINT32_MAX, val);
+}
+
 /// Peripheral register read-only 8 bit
 typedef struct
 {
@@ -30,6 +30,7 @@
  * per_can_set_tir()      start transmision
  * per_can_set_tir_rm()   start transmision of remote message
  * per_can_set_tir_ttc()  start transmision of time triggered communication message
+ * per_can_set_id_tx()    change the identifier of a mailbox without a transmit request
  * per_can_rir()          get identifier information received message
  * per_can_read()         read one message
  * per_can_read_time()    read one message time triggered communication
@@ -89,6 +90,7 @@ typedef enum
     PER_CAN_SET_FIR_SINGLE_BANK_MAX_ERR, ///< Filter bank single number too high on fir set
     PER_CAN_SET_FIR_DUAL_BANK_MAX_ERR, ///< Filter bank dual number too high on fir set
     PER_CAN_BAUDRATE_ERR, ///< Baudrate invalid value
+    PER_CAN_SET_ID_TX_ERR, ///< Identifier above 29 bits on id tx set
 } per_can_error_e;
 
 /// CAN master status register (CAN_MSR)
@@ -296,6 +298,11 @@ typedef struct
             per_bit_n18_t Exid; ///< Extended identifier
             per_bit_r11_t Stid; ///< Standard identifier or extended identifier
         };
+        struct
+        {
+            per_bit_n3_t TirIdBit0; ///< Reserved
+            per_bit_rw29_t Id; ///< Extended identifier, STID and EXID combined
+        };
         per_bit_rw32_reg_t Tir; ///< CAN TX mailbox identifier register (CAN_TIxR)
     };
 
@@ -334,6 +341,11 @@ typedef struct
             per_bit_n18_t Exid; ///< Extended identifier
             per_bit_r11_t Stid; ///< Standard identifier or extended identifier
         };
+        struct
+        {
+            per_bit_n3_t RirIdBit0; ///< Reserved
+            per_bit_r29_t Id; ///< Extended identifier, STID and EXID combined
+        };
         per_bit_r32_reg_t Rir; ///< CAN receive FIFO mailbox identifier register (CAN_RIxR) (x=0..1)
     };
 
@@ -1340,6 +1352,24 @@ static per_inline bool per_can_stid_tx(const per_can_t* const can, const per_can
     return per_bit_r11(&can->Per->Mbxtx[mbx].Stid);
 }
 
+/// Extended identifier, one register read
+static per_inline uint32_t per_can_id_tx(const per_can_t* const can, const per_can_mbx_tx_e mbx)
+{
+    return per_bit_rw29(&can->Per->Mbxtx[mbx].Id);
+}
+
+/// Extended identifier, one exclusive read-modify-write that keeps TXRQ, RTR and IDE
+static per_inline bool per_can_set_id_tx(const per_can_t* const can, const per_can_mbx_tx_e mbx, const uint32_t id)
+{
+    if (id > per_bit_rw29_max())
+    {
+        per_log_err(can->Err, PER_CAN_SET_ID_TX_ERR, id);
+        return false;
+    }
+
+    return per_bit_rw29_set(&can->Per->Mbxtx[mbx].Id, id);
+}
+
 /// TX mailbox identifier register (CAN_TIxR)
 static per_inline uint_fast32_t per_can_tir(const per_can_t* const can, const per_can_mbx_tx_e mbx)
 {
@@ -1562,6 +1592,12 @@ static per_inline uint_fast16_t per_can_stid_rx(const per_can_t* const can, cons
     return per_bit_r11(&can->Per->Mbxrx[mbx].Stid);
 }
 
+/// Extended identifier, one register read
+static per_inline uint32_t per_can_id_rx(const per_can_t* const can, const per_can_mbx_rx_e mbx)
+{
+    return per_bit_r29(&can->Per->Mbxrx[mbx].Id);
+}
+
 /// CAN receive FIFO mailbox identifier register (CAN_RIxR) (x=0..1)
 static per_inline bool per_can_rir(const per_can_t* const can, const per_can_mbx_rx_e mbx, per_can_mess_t* data)
 {
@@ -32,13 +32,13 @@ extern "C"
 {
 #endif
 
-#include "per_dep.h"
+#include "per_addr.h"
 
 /// Address of UID
-#define PER_DES_UID ((uintptr_t)0x1FFF7A10)
+#define PER_DES_UID (PER_ADDR_BASE + (uintptr_t)0x1FFF7A10)
 
 /// Address of programmed flash size value
-#define PER_DES_FLASH_SIZE ((uintptr_t)0x1FFF7A22)
+#define PER_DES_FLASH_SIZE (PER_ADDR_BASE + (uintptr_t)0x1FFF7A22)
 
 typedef struct
 {
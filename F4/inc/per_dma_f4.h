@@ -46,6 +46,14 @@ extern "C" {
 /// DMA2 bit band base address
 #define PER_DMA_2_BB ((per_dma_t*)PER_BIT_REG_TO_BIT_BAND(PER_DMA_2))
 
+#ifdef PER_HOST
+/// DMA Interrupt flag clear written, the host DMA model applies it at once like the hardware
+#define PER_DMA_IFCR_DONE() per_host_dma_sync()
+#else
+/// DMA Interrupt flag clear written
+#define PER_DMA_IFCR_DONE()
+#endif
+
 /// Maximum number of streams
 #define PER_DMA_STREAM_MAX (8)
 
@@ -58,6 +66,8 @@ typedef enum
     PER_DMA_ERR_TRANSFER, ///< Transfer error
     PER_DMA_ERR_DIRECTMODE, ///< Direct mode error
     PER_DMA_ERR_FIFO, ///< FIFO error
+    PER_DMA_ERR_CONFIG, ///< Configuration not valid for the function
+    PER_DMA_ERR_LATE, ///< Next buffer too late, the stream already switched
 } per_dma_error_e;
 
 /// DMA stream enumeration
@@ -140,6 +150,20 @@ typedef enum
     PER_DMA_FTH_FULL          = 0b11, ///< full FIFO
 } per_dma_fth_e;
 
+/// DMA Stream interrupt flags, bit position in the stream part of DMA_LISR/DMA_HISR
+typedef enum
+{
+    PER_DMA_FLAG_FE   = 0b000001, ///< FIFO error
+    PER_DMA_FLAG_DME  = 0b000100, ///< Direct mode error
+    PER_DMA_FLAG_TE   = 0b001000, ///< Transfer error
+    PER_DMA_FLAG_HT   = 0b010000, ///< Half transfer
+    PER_DMA_FLAG_TC   = 0b100000, ///< Transfer complete
+    PER_DMA_FLAG_MASK = 0b111101, ///< All flags
+} per_dma_flag_e;
+
+/// DMA Stream interrupt handler, called with the cleared flags of the stream
+typedef void (*per_dma_irq_handler_t)(per_dma_stream_e stream, per_dma_flag_e flags);
+
 /// DMA Stream-channel options for DMA1
 typedef struct
 {
@@ -277,6 +301,154 @@ typedef struct
     const per_dma_channel_e Chan; ///< Channel
 } per_dma_selection_t;
 
+/// DMA Stream configuration, the DMA_SxCR and DMA_SxFCR settings of a transfer.
+/// Intended as compile time constant, per_dma_apply() then folds it to two register values.
+typedef struct
+{
+    const per_dma_selection_t* Sel; ///< Stream-channel selection
+    per_dma_dir_e Dir; ///< Data transfer direction
+    per_dma_size_e Psize; ///< Peripheral data size
+    per_dma_size_e Msize; ///< Memory data size
+    bool Pinc; ///< Peripheral increment mode
+    bool Minc; ///< Memory increment mode
+    bool Pincos; ///< Peripheral increment offset size
+    bool Circ; ///< Circular mode
+    bool Pfctrl; ///< Peripheral flow controller
+    bool Dbm; ///< Double buffer mode
+    per_dma_burst_e Pburst; ///< Peripheral burst transfer configuration
+    per_dma_burst_e Mburst; ///< Memory burst transfer configuration
+    per_dma_pl_e Pl; ///< Priority level
+    bool Tcie; ///< Transfer complete interrupt enable
+    bool Htie; ///< Half transfer interrupt enable
+    bool Teie; ///< Transfer error interrupt enable
+    bool Dmeie; ///< Direct mode error interrupt enable
+    bool Dmdis; ///< Direct mode disable, FIFO used
+    per_dma_fth_e Fth; ///< FIFO threshold selection
+    bool Feie; ///< FIFO error interrupt enable
+} per_dma_config_t;
+
+/// DMA Double buffer (ping-pong) stream
+typedef struct per_dma_pingpong_s
+{
+    const per_dma_stream_t* Dma; ///< Stream
+    void (*Done)(struct per_dma_pingpong_s* pp, void* buf); ///< Buffer complete callback, called from the interrupt
+    void* volatile Buf[2]; ///< Memory 0 and memory 1 buffer
+    uint16_t Ndt; ///< Number of data items per buffer
+    volatile bool Pending; ///< Completed buffer not replaced yet
+    volatile uint32_t Overrun; ///< Number of buffers that were filled again without a new buffer
+} per_dma_pingpong_t;
+
+/// DMA Scatter-gather segment
+typedef struct
+{
+    const void* Addr; ///< Memory address
+    uint16_t Ndt; ///< Number of data items
+} per_dma_seg_t;
+
+/// DMA Scatter-gather transfer, the segments are transferred one after the other on the same stream
+typedef struct per_dma_sg_s
+{
+    const per_dma_stream_t* Dma; ///< Stream
+    const per_dma_seg_t* Seg; ///< Segments
+    uint_fast16_t Num; ///< Number of segments
+    volatile uint_fast16_t Idx; ///< Segment in progress
+    uint32_t Cr; ///< DMA_SxCR value with enable, to re-arm with one store
+    void (*Done)(struct per_dma_sg_s* sg); ///< Completion callback after the last segment or a transfer error, from the interrupt, can be 0
+    volatile bool Busy; ///< Segments in progress
+    volatile bool Failed; ///< Transfer error, stopped in segment Idx
+    const volatile uint32_t* Clock; ///< Time stamp counter register for the gap measurement, 0 is no measurement
+    uint32_t GapMax; ///< Longest time from the interrupt to the start of the next segment
+    uint32_t GapSum; ///< Total time from the interrupt to the start of the next segment
+    uint32_t Gaps; ///< Number of measured gaps
+} per_dma_sg_t;
+
+/// DMA Number of memory copy jobs that can wait, must be a power of two
+#ifndef PER_DMA_COPY_QUEUE
+#define PER_DMA_COPY_QUEUE 8
+#endif
+
+/// DMA Memory copy job, owned by the engine from per_dma_memcpy_async() until Busy is false
+typedef struct per_dma_copy_s
+{
+    uint8_t* Dest; ///< Destination
+    const uint8_t* Src; ///< Source
+    uint32_t Size; ///< Number of bytes
+    uint32_t Off; ///< Number of bytes copied
+    void (*Done)(struct per_dma_copy_s* job); ///< Completion callback from the interrupt, can be 0
+    volatile bool Busy; ///< Poll handle, queued or copying
+    volatile bool Failed; ///< Transfer error, copy not complete
+} per_dma_copy_t;
+
+/// DMA Memory copy engine on a DMA2 stream
+typedef struct
+{
+    const per_dma_stream_t* Dma; ///< Stream
+    per_dma_pl_e Pl; ///< Priority level
+    per_dma_copy_t* volatile Queue[PER_DMA_COPY_QUEUE]; ///< Waiting jobs
+    volatile uint32_t Head; ///< Queue position of the next job
+    volatile uint32_t Tail; ///< Queue position of the oldest job
+    per_dma_copy_t* volatile Run; ///< Job in progress, 0 when idle
+    uint32_t Chunk; ///< Number of bytes of the transfer in progress
+} per_dma_memcpy_t;
+
+/// DMA bit position of a configuration field in its register
+#define PER_DMA_CONF_SHIFT(FIELD, FIRST) ((offsetof(per_dma_conf_t, FIELD) - offsetof(per_dma_conf_t, FIRST)) / sizeof(per_bit_bitband_t))
+
+/// DMA Statistics of a stream, collected with PER_DMA_STATS defined
+typedef struct
+{
+    uint32_t Transfers; ///< Number of completed transfers
+    uint32_t Bytes; ///< Number of bytes of the completed transfers, peripheral data size
+    uint32_t Errors; ///< Number of transfer, direct mode and FIFO errors
+    uint32_t Busy; ///< Total time from start to complete, clock counts
+    uint32_t Max; ///< Longest time from start to complete, clock counts
+    uint32_t Start; ///< Time of the start of the transfer in progress
+    uint32_t Size; ///< Number of bytes of the transfer in progress
+} per_dma_stats_t;
+
+/// DMA Number of streams with statistics, DMA1 and DMA2
+#define PER_DMA_STATS_MAX (2 * PER_DMA_STREAM_MAX)
+
+#ifdef PER_DMA_STATS
+void per_dma_stats_start(uint_fast8_t idx, uint32_t size);
+
+void per_dma_stats_flags(uint_fast8_t idx, uint32_t flags);
+
+void per_dma_stats_set_clock(const volatile uint32_t* counter);
+
+void per_dma_stats_snapshot(per_dma_stats_t stats[PER_DMA_STATS_MAX], bool reset);
+#endif
+
+/// DMA Statistics index of a stream, DMA1 stream 0..7 and DMA2 stream 0..7
+static per_inline uint_fast8_t per_dma_stats_idx(const per_dma_stream_t* const dma)
+{
+    return (dma->Err <= PER_LOG_DMA_1_STREAM_7) ? (uint_fast8_t)(dma->Err - PER_LOG_DMA_1_STREAM_0) :
+                                                  (uint_fast8_t)(PER_DMA_STREAM_MAX + dma->Err - PER_LOG_DMA_2_STREAM_0);
+}
+
+/// DMA Statistics start of a transfer, cr is the DMA_SxCR value for the peripheral data size
+static per_inline void per_dma_stats_on_start(const per_dma_stream_t* const dma, uint_fast16_t ndt, uint32_t cr)
+{
+#ifdef PER_DMA_STATS
+    per_dma_stats_start(per_dma_stats_idx(dma), (uint32_t)ndt << ((cr >> PER_DMA_CONF_SHIFT(Psize, En)) & 0b11));
+#else
+    (void)dma;
+    (void)ndt;
+    (void)cr;
+#endif
+}
+
+/// DMA Statistics flags of a stream, transfer complete and errors
+static per_inline void per_dma_stats_on_flags(uint_fast8_t idx, uint32_t flags)
+{
+#ifdef PER_DMA_STATS
+    per_dma_stats_flags(idx, flags);
+#else
+    (void)idx;
+    (void)flags;
+#endif
+}
+
 /// DMA Stream enable / flag stream ready when read low
 static per_inline bool per_dma_en(const per_dma_stream_t* const dma)
 {
@@ -286,6 +458,13 @@ static per_inline bool per_dma_en(const per_dma_stream_t* const dma)
 /// DMA Stream enable / flag stream ready when read low
 static per_inline void per_dma_set_en(const per_dma_stream_t* const dma, bool val)
 {
+#ifdef PER_DMA_STATS
+    if (val)
+    {
+        per_dma_stats_on_start(dma, per_bit_rw16_reg(&dma->Conf->Ndt), (uint32_t)per_bit_rw2(&dma->Conf->Psize) << PER_DMA_CONF_SHIFT(Psize, En));
+    }
+#endif
+
     per_bit_rw1_set(&dma->Conf->En, val);
 }
 
@@ -601,6 +780,183 @@ static per_inline void per_dma_set_feie(const per_dma_stream_t* const dma, bool
     per_bit_rw1_set(&dma->Conf->Feie, val);
 }
 
+/// DMA Direct mode error interrupt enable in a transaction
+static per_inline bool per_dma_trans_set_dmeie(per_bit_trans_t* trans, const per_dma_stream_t* const dma, bool val)
+{
+    return per_bit_rw1_trans_set(trans, &dma->Conf->Dmeie, val);
+}
+
+/// DMA Transfer error interrupt enable in a transaction
+static per_inline bool per_dma_trans_set_teie(per_bit_trans_t* trans, const per_dma_stream_t* const dma, bool val)
+{
+    return per_bit_rw1_trans_set(trans, &dma->Conf->Teie, val);
+}
+
+/// DMA Half transfer interrupt enable in a transaction
+static per_inline bool per_dma_trans_set_htie(per_bit_trans_t* trans, const per_dma_stream_t* const dma, bool val)
+{
+    return per_bit_rw1_trans_set(trans, &dma->Conf->Htie, val);
+}
+
+/// DMA Transfer complete interrupt enable in a transaction
+static per_inline bool per_dma_trans_set_tcie(per_bit_trans_t* trans, const per_dma_stream_t* const dma, bool val)
+{
+    return per_bit_rw1_trans_set(trans, &dma->Conf->Tcie, val);
+}
+
+/// DMA Peripheral flow controller in a transaction
+static per_inline bool per_dma_trans_set_pfctrl(per_bit_trans_t* trans, const per_dma_stream_t* const dma, bool val)
+{
+    return per_bit_rw1_trans_set(trans, &dma->Conf->Pfctrl, val);
+}
+
+/// DMA Data transfer direction in a transaction
+static per_inline bool per_dma_trans_set_dir(per_bit_trans_t* trans, const per_dma_stream_t* const dma, per_dma_dir_e dir)
+{
+    return per_bit_rw2_trans_set(trans, &dma->Conf->Dir, (uint_fast16_t)dir);
+}
+
+/// DMA Circular mode in a transaction
+static per_inline bool per_dma_trans_set_circ(per_bit_trans_t* trans, const per_dma_stream_t* const dma, bool val)
+{
+    return per_bit_rw1_trans_set(trans, &dma->Conf->Circ, val);
+}
+
+/// DMA Peripheral increment mode in a transaction
+static per_inline bool per_dma_trans_set_pinc(per_bit_trans_t* trans, const per_dma_stream_t* const dma, bool val)
+{
+    return per_bit_rw1_trans_set(trans, &dma->Conf->Pinc, val);
+}
+
+/// DMA Memory increment mode in a transaction
+static per_inline bool per_dma_trans_set_minc(per_bit_trans_t* trans, const per_dma_stream_t* const dma, bool val)
+{
+    return per_bit_rw1_trans_set(trans, &dma->Conf->Minc, val);
+}
+
+/// DMA peripheral data size set in a transaction
+static per_inline bool per_dma_trans_set_psize(per_bit_trans_t* trans, const per_dma_stream_t* const dma, per_dma_size_e size)
+{
+    return per_bit_rw2_trans_set(trans, &dma->Conf->Psize, (uint_fast16_t)size);
+}
+
+/// DMA memory data size set in a transaction
+static per_inline bool per_dma_trans_set_msize(per_bit_trans_t* trans, const per_dma_stream_t* const dma, per_dma_size_e size)
+{
+    return per_bit_rw2_trans_set(trans, &dma->Conf->Msize, (uint_fast16_t)size);
+}
+
+/// DMA Peripheral increment offset size in a transaction
+static per_inline bool per_dma_trans_set_pincos(per_bit_trans_t* trans, const per_dma_stream_t* const dma, bool val)
+{
+    return per_bit_rw1_trans_set(trans, &dma->Conf->Pincos, val);
+}
+
+/// DMA priority set in a transaction
+static per_inline bool per_dma_trans_set_pl(per_bit_trans_t* trans, const per_dma_stream_t* const dma, per_dma_pl_e prio)
+{
+    return per_bit_rw2_trans_set(trans, &dma->Conf->Pl, (uint_fast16_t)prio);
+}
+
+/// DMA Double buffer mode in a transaction
+static per_inline bool per_dma_trans_set_dbm(per_bit_trans_t* trans, const per_dma_stream_t* const dma, bool val)
+{
+    return per_bit_rw1_trans_set(trans, &dma->Conf->Dbm, val);
+}
+
+/// DMA Current target (only in double buffer mode) in a transaction
+static per_inline bool per_dma_trans_set_ct(per_bit_trans_t* trans, const per_dma_stream_t* const dma, bool val)
+{
+    return per_bit_rw1_trans_set(trans, &dma->Conf->Ct, val);
+}
+
+/// DMA peripheral burst size set in a transaction
+static per_inline bool per_dma_trans_set_pburst(per_bit_trans_t* trans, const per_dma_stream_t* const dma, per_dma_burst_e burst)
+{
+    return per_bit_rw2_trans_set(trans, &dma->Conf->Pburst, (uint_fast16_t)burst);
+}
+
+/// DMA memory burst size set in a transaction
+static per_inline bool per_dma_trans_set_mburst(per_bit_trans_t* trans, const per_dma_stream_t* const dma, per_dma_burst_e burst)
+{
+    return per_bit_rw2_trans_set(trans, &dma->Conf->Mburst, (uint_fast16_t)burst);
+}
+
+/// DMA Channel selection in a transaction
+static per_inline bool per_dma_trans_set_chsel(per_bit_trans_t* trans, const per_dma_stream_t* const dma, const per_dma_selection_t* selection)
+{
+    if (dma->Conf != selection->Conf)
+    {
+        per_dep_err_unsupported();
+    }
+
+    return per_bit_rw3_trans_set(trans, &dma->Conf->Chsel, (uint_fast16_t)selection->Chan);
+}
+
+/// DMA FIFO threshold level in a transaction
+static per_inline bool per_dma_trans_set_fth(per_bit_trans_t* trans, const per_dma_stream_t* const dma, per_dma_fth_e lev)
+{
+    return per_bit_rw2_trans_set(trans, &dma->Conf->Fth, (uint_fast16_t)lev);
+}
+
+/// DMA Direct mode disable in a transaction
+static per_inline bool per_dma_trans_set_dmdis(per_bit_trans_t* trans, const per_dma_stream_t* const dma, bool val)
+{
+    return per_bit_rw1_trans_set(trans, &dma->Conf->Dmdis, val);
+}
+
+/// DMA FIFO error interrupt enable in a transaction
+static per_inline bool per_dma_trans_set_feie(per_bit_trans_t* trans, const per_dma_stream_t* const dma, bool val)
+{
+    return per_bit_rw1_trans_set(trans, &dma->Conf->Feie, val);
+}
+
+/// DMA Stream control register value of a configuration, without the enable
+static per_inline uint32_t per_dma_config_cr(const per_dma_config_t* const config)
+{
+    return ((uint32_t)config->Dmeie << PER_DMA_CONF_SHIFT(Dmeie, En)) |
+           ((uint32_t)config->Teie << PER_DMA_CONF_SHIFT(Teie, En)) |
+           ((uint32_t)config->Htie << PER_DMA_CONF_SHIFT(Htie, En)) |
+           ((uint32_t)config->Tcie << PER_DMA_CONF_SHIFT(Tcie, En)) |
+           ((uint32_t)config->Pfctrl << PER_DMA_CONF_SHIFT(Pfctrl, En)) |
+           ((uint32_t)config->Dir << PER_DMA_CONF_SHIFT(Dir, En)) |
+           ((uint32_t)config->Circ << PER_DMA_CONF_SHIFT(Circ, En)) |
+           ((uint32_t)config->Pinc << PER_DMA_CONF_SHIFT(Pinc, En)) |
+           ((uint32_t)config->Minc << PER_DMA_CONF_SHIFT(Minc, En)) |
+           ((uint32_t)config->Psize << PER_DMA_CONF_SHIFT(Psize, En)) |
+           ((uint32_t)config->Msize << PER_DMA_CONF_SHIFT(Msize, En)) |
+           ((uint32_t)config->Pincos << PER_DMA_CONF_SHIFT(Pincos, En)) |
+           ((uint32_t)config->Pl << PER_DMA_CONF_SHIFT(Pl, En)) |
+           ((uint32_t)config->Dbm << PER_DMA_CONF_SHIFT(Dbm, En)) |
+           ((uint32_t)config->Pburst << PER_DMA_CONF_SHIFT(Pburst, En)) |
+           ((uint32_t)config->Mburst << PER_DMA_CONF_SHIFT(Mburst, En)) |
+           ((uint32_t)config->Sel->Chan << PER_DMA_CONF_SHIFT(Chsel, En));
+}
+
+/// DMA Stream FIFO control register value of a configuration
+static per_inline uint32_t per_dma_config_fcr(const per_dma_config_t* const config)
+{
+    return ((uint32_t)config->Fth << PER_DMA_CONF_SHIFT(Fth, Fth)) |
+           ((uint32_t)config->Dmdis << PER_DMA_CONF_SHIFT(Dmdis, Fth)) |
+           ((uint32_t)config->Feie << PER_DMA_CONF_SHIFT(Feie, Fth));
+}
+
+/// DMA Stream write the transfer registers, DMA_SxCR last as it holds the enable
+static per_inline void per_dma_write(const per_dma_stream_t* const dma, uint32_t cr, uint32_t fcr, uint16_t ndt, uint_fast32_t par, uint_fast32_t m0a)
+{
+    PER_BIT_BIT_BAND_TO_REG(&dma->Conf->Fth)->Reg32 = fcr;
+    per_bit_rw16_reg_set(&dma->Conf->Ndt, ndt);
+    per_bit_rw32_reg_set(&dma->Conf->Par, (uint32_t)par);
+    per_bit_rw32_reg_set(&dma->Conf->M0a, (uint32_t)m0a);
+
+    if ((cr & 1) != 0)
+    {
+        per_dma_stats_on_start(dma, ndt, cr);
+    }
+
+    PER_BIT_BIT_BAND_TO_REG(&dma->Conf->En)->Reg32 = cr;
+}
+
 /// DMA Stream FIFO error interrupt flag
 static per_inline bool per_dma_feif(const per_dma_stream_t* const dma)
 {
@@ -635,30 +991,35 @@ static per_inline bool per_dma_tcif(const per_dma_stream_t* const dma)
 static per_inline void per_dma_clr_cdmeif(const per_dma_stream_t* const dma)
 {
     per_bit_w1_set(&dma->Ifcr->Cdmeif, true);
+    PER_DMA_IFCR_DONE();
 }
 
 /// DMA Stream FIFO error interrupt flag
 static per_inline void per_dma_clr_cfeif(const per_dma_stream_t* const dma)
 {
     per_bit_w1_set(&dma->Ifcr->Cfeif, true);
+    PER_DMA_IFCR_DONE();
 }
 
 /// DMA  Stream transfer error interrupt flag
 static per_inline void per_dma_clr_cteif(const per_dma_stream_t* const dma)
 {
     per_bit_w1_set(&dma->Ifcr->Cteif, true);
+    PER_DMA_IFCR_DONE();
 }
 
 /// DMA Stream half transfer interrupt flag
 static per_inline void per_dma_clr_chtif(const per_dma_stream_t* const dma)
 {
     per_bit_w1_set(&dma->Ifcr->Chtif, true);
+    PER_DMA_IFCR_DONE();
 }
 
 /// DMA Stream transfer complete interrupt flag
 static per_inline void per_dma_clr_ctcif(const per_dma_stream_t* const dma)
 {
     per_bit_w1_set(&dma->Ifcr->Ctcif, true);
+    PER_DMA_IFCR_DONE();
 }
 
 /// DMA Check stream for direct mode error and log and clear it
@@ -668,6 +1029,7 @@ static per_inline void per_dma_clr_dmeif(const per_dma_stream_t* const dma)
     {
         per_dma_clr_cdmeif(dma);
         per_log_err(dma->Err, PER_DMA_ERR_DIRECTMODE, 0);
+        per_dma_stats_on_flags(per_dma_stats_idx(dma), PER_DMA_FLAG_DME);
     }
 }
 
@@ -678,6 +1040,7 @@ static per_inline void per_dma_clr_feif(const per_dma_stream_t* const dma)
     {
         per_dma_clr_cfeif(dma);
         per_log_err(dma->Err, PER_DMA_ERR_FIFO, 0);
+        per_dma_stats_on_flags(per_dma_stats_idx(dma), PER_DMA_FLAG_FE);
     }
 }
 
@@ -688,9 +1051,238 @@ static per_inline void per_dma_clr_teif(const per_dma_stream_t* const dma)
     {
         per_dma_clr_cteif(dma);
         per_log_err(dma->Err, PER_DMA_ERR_TRANSFER, 0);
+        per_dma_stats_on_flags(per_dma_stats_idx(dma), PER_DMA_FLAG_TE);
+    }
+}
+
+/// DMA Stream fetch and clear the active flags, one read of DMA_xISR and one write of DMA_xIFCR
+static per_inline per_dma_flag_e per_dma_stream_irq(const per_dma_stream_t* const dma)
+{
+    const uint32_t flags = (PER_BIT_BIT_BAND_TO_REG(dma->Isr)->Reg32 >> PER_BIT_SHIFT(dma->Isr)) & (uint32_t)PER_DMA_FLAG_MASK;
+
+    PER_BIT_BIT_BAND_TO_REG(dma->Ifcr)->Reg32 = flags << PER_BIT_SHIFT(dma->Ifcr); // Clear
+    PER_DMA_IFCR_DONE();
+    per_dma_stats_on_flags(per_dma_stats_idx(dma), flags);
+
+    return (per_dma_flag_e)flags;
+}
+
+/// DMA fetch and clear the active flags of all the streams with a handler and call the handlers.
+/// One read of DMA_LISR and DMA_HISR and one write of DMA_LIFCR and DMA_HIFCR for all streams.
+/// Streams without handler (0) keep their flags, for polling. Returns a bitmask of the streams that had flags.
+static per_inline uint_fast8_t per_dma_irq(per_dma_t* const dma, const per_dma_irq_handler_t handler[PER_DMA_STREAM_MAX])
+{
+    static const uint8_t shift[PER_DMA_STREAM_MAX / 2] = {0, 6, 16, 22}; // Stream position in the status register
+    volatile uint32_t* const isr = &PER_BIT_BIT_BAND_TO_REG(&dma->Isr0)->Reg32; // DMA_LISR, DMA_HISR
+    volatile uint32_t* const ifcr = &PER_BIT_BIT_BAND_TO_REG(&dma->Ifcr0)->Reg32; // DMA_LIFCR, DMA_HIFCR
+    uint32_t flags[2] = {0, 0};
+    uint_fast8_t active = 0;
+    uint_fast8_t str = 0;
+
+    while (str < PER_DMA_STREAM_MAX)
+    {
+        if (handler[str] != 0)
+        {
+            flags[str / 4] |= (uint32_t)PER_DMA_FLAG_MASK << shift[str % 4];
+        }
+
+        ++str;
+    }
+
+    flags[0] &= isr[0];
+    flags[1] &= isr[1];
+    ifcr[0] = flags[0]; // Clear
+    ifcr[1] = flags[1];
+    PER_DMA_IFCR_DONE();
+
+    str = 0;
+
+    while (str < PER_DMA_STREAM_MAX)
+    {
+        const uint32_t fl = (flags[str / 4] >> shift[str % 4]) & (uint32_t)PER_DMA_FLAG_MASK;
+
+        if (fl != 0)
+        {
+            per_dma_stats_on_flags((dma == PER_DMA_1_BB) ? str : (PER_DMA_STREAM_MAX + str), fl);
+            active |= (uint_fast8_t)(1 << str);
+            handler[str]((per_dma_stream_e)str, (per_dma_flag_e)fl);
+        }
+
+        ++str;
     }
+
+    return active;
 }
 
+/// DMA Stream program a complete transfer, one store per register: DMA_SxFCR, DMA_SxNDTR, DMA_SxPAR, DMA_SxM0AR and DMA_SxCR last with the enable.
+/// The stream must be disabled, otherwise the busy error is logged and nothing is written.
+/// With en the stale flags of the stream are cleared first, the stream does not start with flags set.
+static per_inline bool per_dma_apply(const per_dma_stream_t* const dma, const per_dma_config_t* const config, uint16_t ndt, uint_fast32_t par, uint_fast32_t m0a, bool en)
+{
+    if (dma->Conf != config->Sel->Conf)
+    {
+        per_dep_err_unsupported();
+    }
+
+    if (per_dma_en(dma))
+    {
+        per_log_err(dma->Err, PER_DMA_ERR_BUSY, 0);
+        return false;
+    }
+
+    if (en)
+    {
+        (void)per_dma_stream_irq(dma); // Clear old flags
+    }
+
+    per_dma_write(dma, per_dma_config_cr(config) | (uint32_t)en, per_dma_config_fcr(config), ndt, par, m0a);
+
+    return true;
+}
+
+/// DMA Double buffer start, the stream fills buf0 and buf1 alternately without stopping.
+/// The configuration must have double buffer mode and the transfer complete interrupt enabled.
+static per_inline bool per_dma_pingpong_start(per_dma_pingpong_t* pp, const per_dma_stream_t* const dma, const per_dma_config_t* const config,
+                                              uint16_t ndt, uint_fast32_t par, void* buf0, void* buf1, void (*done)(per_dma_pingpong_t* pp, void* buf))
+{
+    if (!config->Dbm || !config->Tcie)
+    {
+        per_log_err(dma->Err, PER_DMA_ERR_CONFIG, 0);
+        return false;
+    }
+
+    pp->Dma = dma;
+    pp->Done = done;
+    pp->Buf[0] = buf0;
+    pp->Buf[1] = buf1;
+    pp->Ndt = ndt;
+    pp->Pending = false;
+    pp->Overrun = 0;
+    per_dma_set_m1a(dma, (uint32_t)(uintptr_t)buf1);
+
+    return per_dma_apply(dma, config, ndt, par, (uint32_t)(uintptr_t)buf0, true);
+}
+
+/// DMA Minimum number of items left in the target in use for per_dma_pingpong_next() to write the other address register
+#ifndef PER_DMA_PINGPONG_MARGIN
+#define PER_DMA_PINGPONG_MARGIN (2)
+#endif
+
+/// DMA Double buffer next buffer, replaces the completed buffer while the stream fills the other one.
+/// Call before the other buffer completes, typically from the done callback. Without a new buffer
+/// the completed buffer is filled again and counted as overrun.
+/// Writing the address register of the target in use sets TEIF and disables the stream, so the buffer is
+/// refused when the target in use has PER_DMA_PINGPONG_MARGIN items or less left. When the stream switched
+/// between the check and the write anyway, it is restarted on the new buffer and the late write is logged.
+static per_inline bool per_dma_pingpong_next(per_dma_pingpong_t* pp, void* buf)
+{
+    const per_dma_stream_t* const dma = pp->Dma;
+    const bool ct = per_dma_ct(dma); // Target in use
+
+    if (per_dma_ndt(dma) <= PER_DMA_PINGPONG_MARGIN) // The switch is too close, the write could hit the target in use
+    {
+        per_log_err(dma->Err, PER_DMA_ERR_LATE, (uint_fast32_t)(uintptr_t)buf);
+        return false;
+    }
+
+    if (ct)
+    {
+        per_dma_set_m0a(dma, (uint32_t)(uintptr_t)buf);
+    }
+    else
+    {
+        per_dma_set_m1a(dma, (uint32_t)(uintptr_t)buf);
+    }
+
+    if (per_dma_ct(dma) != ct) // Switched meanwhile, the write hit the target in use and the stream stopped
+    {
+        while (per_dma_en(dma))
+        {
+        }
+
+        per_dma_clr_cteif(dma); // The completed buffer keeps its TCIF for per_dma_pingpong_irq()
+
+        if (ct)
+        {
+            per_dma_set_m0a(dma, (uint32_t)(uintptr_t)buf);
+        }
+        else
+        {
+            per_dma_set_m1a(dma, (uint32_t)(uintptr_t)buf);
+        }
+
+        per_dma_set_ndt(dma, pp->Ndt);
+        per_dma_set_en(dma, true); // Continues with CT unchanged, on the new buffer
+        per_log_err(dma->Err, PER_DMA_ERR_LATE, (uint_fast32_t)(uintptr_t)buf);
+    }
+
+    pp->Buf[!ct] = buf;
+    pp->Pending = false;
+
+    return true;
+}
+
+/// DMA Double buffer interrupt, call from the stream interrupt with the flags of per_dma_stream_irq() or per_dma_irq()
+static per_inline void per_dma_pingpong_irq(per_dma_pingpong_t* pp, per_dma_flag_e flags)
+{
+    if ((flags & PER_DMA_FLAG_TE) != 0)
+    {
+        per_log_err(pp->Dma->Err, PER_DMA_ERR_TRANSFER, 0);
+    }
+
+    if ((flags & PER_DMA_FLAG_TC) != 0)
+    {
+        if (pp->Pending)
+        {
+            ++pp->Overrun;
+        }
+
+        pp->Pending = true;
+        pp->Done(pp, pp->Buf[!per_dma_ct(pp->Dma)]); // The target not in use is complete
+    }
+}
+
+/// DMA Scatter-gather start, the configuration describes all segments and its transfer complete interrupt is always enabled.
+/// The stream interrupt must call per_dma_sg_irq(). Set sg->Clock before the start to measure the gaps between segments.
+static per_inline bool per_dma_sg_start(per_dma_sg_t* sg, const per_dma_stream_t* const dma, const per_dma_config_t* const config,
+                                        uint_fast32_t par, const per_dma_seg_t* seg, uint_fast16_t num, void (*done)(per_dma_sg_t* sg))
+{
+    if (dma->Conf != config->Sel->Conf)
+    {
+        per_dep_err_unsupported();
+    }
+
+    if (per_dma_en(dma) || (num == 0))
+    {
+        per_log_err(dma->Err, PER_DMA_ERR_BUSY, num);
+        return false;
+    }
+
+    sg->Dma = dma;
+    sg->Seg = seg;
+    sg->Num = num;
+    sg->Idx = 0;
+    sg->Cr = per_dma_config_cr(config) | ((uint32_t)1 << PER_DMA_CONF_SHIFT(Tcie, En)) | (uint32_t)1;
+    sg->Done = done;
+    sg->Busy = true;
+    sg->Failed = false;
+    sg->GapMax = 0;
+    sg->GapSum = 0;
+    sg->Gaps = 0;
+    (void)per_dma_stream_irq(dma); // Clear old flags
+    per_dma_write(dma, sg->Cr, per_dma_config_fcr(config), seg[0].Ndt, par, (uint_fast32_t)(uintptr_t)seg[0].Addr);
+
+    return true;
+}
+
+void per_dma_sg_irq(per_dma_sg_t* sg, per_dma_flag_e flags);
+
+bool per_dma_memcpy_init(per_dma_memcpy_t* eng, const per_dma_stream_t* const dma, per_dma_pl_e pl);
+
+bool per_dma_memcpy_async(per_dma_memcpy_t* eng, per_dma_copy_t* job, void* dest, const void* src, uint32_t size, void (*done)(per_dma_copy_t* job));
+
+void per_dma_memcpy_irq(per_dma_memcpy_t* eng);
+
 #ifdef __cplusplus
 }
 #endif
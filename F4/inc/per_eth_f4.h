@@ -544,13 +544,29 @@ typedef struct
     per_bit_r32_reg_t Sts; ///< System time second
 
     // PTP time stamp low register (ETH_PTPTSLR)
-    per_bit_r32_reg_t Stss; ///< System time subseconds. Note used as signed int32
+    union
+    {
+        struct
+        {
+            per_bit_r31_t Stssv; ///< System time subseconds value
+            per_bit_r1_t Stpns; ///< System time positive or negative sign
+        };
+        per_bit_r32_reg_t Stss; ///< System time subseconds. Note used as signed int32
+    };
 
     // PTP time stamp high update register (ETH_PTPTSHUR)
     per_bit_rw32_reg_t Tsus; ///< Time stamp update second
 
     // PTP time stamp low update register (ETH_PTPTSLUR)
-    per_bit_rw32_reg_t Tsuss; ///< Time stamp update subseconds. Note used as signed int32
+    union
+    {
+        struct
+        {
+            per_bit_rw31_t Tsussv; ///< Time stamp update subseconds value
+            per_bit_rw1_t Tsupns; ///< Time stamp update positive or negative sign
+        };
+        per_bit_rw32_reg_t Tsuss; ///< Time stamp update subseconds. Note used as signed int32
+    };
 
     // PTP time stamp addend register (ETH_PTPTSAR)
     per_bit_rw32_reg_t Tsa; ///< Time stamp addend
@@ -2133,6 +2149,18 @@ static per_inline int32_t per_eth_ptp_stss(const per_eth_t* const eth)
     return (int32_t)per_bit_r32_reg(&eth->PerPtp->Stss);
 }
 
+/// System time subseconds value, one register read
+static per_inline uint32_t per_eth_ptp_stssv(const per_eth_t* const eth)
+{
+    return per_bit_r31(&eth->PerPtp->Stssv);
+}
+
+/// System time positive or negative sign
+static per_inline bool per_eth_ptp_stpns(const per_eth_t* const eth)
+{
+    return per_bit_r1(&eth->PerPtp->Stpns);
+}
+
 ///Time stamp update second
 static per_inline uint32_t per_eth_ptp_tsus(const per_eth_t* const eth)
 {
@@ -2157,6 +2185,30 @@ static per_inline void per_eth_ptp_set_tsuss(const per_eth_t* const eth, int32_t
     per_bit_rw32_reg_set(&eth->PerPtp->Tsuss, (uint32_t)val);
 }
 
+/// Time stamp update subseconds value
+static per_inline uint32_t per_eth_ptp_tsussv(const per_eth_t* const eth)
+{
+    return per_bit_rw31(&eth->PerPtp->Tsussv);
+}
+
+/// Time stamp update subseconds value, one register read-modify-write
+static per_inline bool per_eth_ptp_set_tsussv(const per_eth_t* const eth, uint32_t val)
+{
+    return per_bit_rw31_set(&eth->PerPtp->Tsussv, val);
+}
+
+/// Time stamp update positive or negative sign
+static per_inline bool per_eth_ptp_tsupns(const per_eth_t* const eth)
+{
+    return per_bit_rw1(&eth->PerPtp->Tsupns);
+}
+
+/// Time stamp update positive or negative sign
+static per_inline void per_eth_ptp_set_tsupns(const per_eth_t* const eth, bool val)
+{
+    per_bit_rw1_set(&eth->PerPtp->Tsupns, val);
+}
+
 /// Time stamp addend
 static per_inline uint32_t per_eth_ptp_tsa(const per_eth_t* const eth)
 {
@@ -97,7 +97,7 @@ typedef struct
 /// GPIO get input
 static per_inline bool per_gpio_in(const per_gpio_in_t* const self)
 {
-    return self->R.Bit8 != PER_BIT_0;
+    return PER_BIT_BB_GET(&self->R) != PER_BIT_0;
 }
 
 /// Output type
@@ -109,13 +109,13 @@ typedef struct
 /// GPIO get output
 static per_inline bool per_gpio_out(const per_gpio_out_t* const self)
 {
-    return self->Rw.Bit8 != PER_BIT_0;
+    return PER_BIT_BB_GET(&self->Rw) != PER_BIT_0;
 }
 
 /// GPIO set output
 static per_inline void per_gpio_set_out(per_gpio_out_t* const self, bool val)
 {
-    self->Rw.Bit8 = (uint_fast8_t)val; // one cycle faster compared to per_gpio_set_bsrr()
+    PER_BIT_BB_SET(&self->Rw, (uint_fast8_t)val); // one cycle faster compared to per_gpio_set_bsrr()
 }
 
 /// GPIO pin enumeration
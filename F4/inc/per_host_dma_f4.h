@@ -0,0 +1,80 @@
+/**
+ * @file per_host_dma_f4.h
+ *
+ * This file contains the host behavioural model of the DMA controllers
+ *
+ * Copyright (c) 2023 admaunaloa admaunaloa@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ * The model works on the DMA1 and DMA2 registers in the host shadow area
+ * (per_host_f4.h), so the unchanged per_dma_ driver code programs it.
+ * It follows DMA_SxCR: direction, PINC/PINCOS/MINC, PSIZE, circular and double
+ * buffer mode with CT, and counts DMA_SxNDTR down. It sets the TC, HT flags in
+ * DMA_LISR/DMA_HISR and a DMA_xIFCR write clears them: the per_dma_ functions
+ * that write DMA_xIFCR call per_host_dma_sync(), so the clear is seen at once.
+ *
+ * The model runs only in its functions:
+ * per_host_dma_tick()      every active stream moves one data item per tick
+ * per_host_dma_request()   a peripheral requests data items of a stream
+ * per_host_dma_sync()      applies the stream enable changes and DMA_xIFCR writes
+ *
+ * Memory to memory streams are always active, peripheral streams when their
+ * request callback returns true. The memory and peripheral addresses are target
+ * addresses, per_host_ptr() gives the host pointer of a buffer at a target
+ * address. The interrupt callback is called for each flag that has its interrupt
+ * enabled, like the NVIC would.
+ *
+ * Limitations:
+ * The FIFO is not modelled, NDTR counts peripheral data items and the memory
+ * side is packed accordingly. In direct mode MSIZE is not used, like on the
+ * target. With the FIFO and MSIZE different from PSIZE the memory address must
+ * increment and NDTR must be a multiple of the packing, otherwise the stream
+ * does not start and PER_DMA_ERR_CONFIG is logged. Bursts, priorities and the
+ * error flags are not modelled.
+ */
+
+#ifndef per_host_dma_f4_h_
+#define per_host_dma_f4_h_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "per_host_f4.h"
+#include "per_dma_f4.h"
+
+void per_host_dma_reset(void);
+
+void per_host_dma_sync(void);
+
+uint_fast32_t per_host_dma_tick(uint_fast32_t ticks);
+
+uint_fast32_t per_host_dma_request(per_dma_t* dma, per_dma_stream_e str, uint_fast32_t items);
+
+void per_host_dma_set_request(per_dma_t* dma, per_dma_stream_e str, bool (*req)(void* ctx), void* ctx);
+
+void per_host_dma_set_irq(void (*irq)(per_dma_t* dma, per_dma_stream_e str));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // per_host_dma_f4_h_
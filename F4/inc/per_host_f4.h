@@ -0,0 +1,74 @@
+/**
+ * @file per_host_f4.h
+ *
+ * This file contains the host register simulator interface
+ *
+ * Copyright (c) 2023 admaunaloa admaunaloa@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The host backend is selected by compiling with PER_HOST defined.
+ * The complete 4 Gbyte target address space is then mirrored in a lazily
+ * allocated shadow area at PER_HOST_BASE. per_addr.h adds this base to all the
+ * addresses, so the peripheral registers are plain memory on the host.
+ * The bitband alias is never dereferenced on the host, bit accesses are
+ * decoded by per_bit_f4.h and applied to the backing register.
+ *
+ * The shadow area is mapped before main() is called, the per_ API runs
+ * unchanged in a normal (64 bit Linux) program.
+ *
+ * Limitations:
+ * Registers are memory, hardware side effects are not simulated.
+ * For example rc_w1 flags are not cleared by writing one.
+ * Tests can emulate the hardware by writing the registers directly.
+ */
+
+#ifndef per_host_f4_h_
+#define per_host_f4_h_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "per_dep.h"
+
+/// Host shadow address space base, 4 Gbyte aligned and outside the usual Linux program and heap areas
+#define PER_HOST_BASE ((uintptr_t)0x100000000000)
+
+/// Host shadow address space size, the complete 32 bit target address space
+#define PER_HOST_SIZE ((uintptr_t)0x100000000)
+
+bool per_host_init(void);
+
+void per_host_clear(void);
+
+/// DMA_xIFCR written by the driver, the DMA model (per_host_dma_f4.c) overrides the default that does nothing
+void per_host_dma_sync(void);
+
+/// Host pointer of a target address, for example a DMA buffer in SRAM at 0x20000000
+static per_inline void* per_host_ptr(uint32_t addr)
+{
+    return (void*)(PER_HOST_BASE + addr);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // per_host_f4_h_
@@ -0,0 +1,96 @@
+/**
+ * @file per_host_usart_f4.h
+ *
+ * This file contains the host behavioural model of the USART serial lines
+ *
+ * Copyright (c) 2023 admaunaloa admaunaloa@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * The model works on the USART registers in the host shadow area
+ * (per_host_f4.h), so the unchanged per_usart_ and bsp_usart_ driver code
+ * programs it. A link wires the transmitter of one USART to the receiver of
+ * an other one. The character time follows BRR, OVER8, M and STOP of the
+ * transmitter and the clock of the link.
+ *
+ * A DR write of the transmitter is seen by the model because it keeps DR of
+ * the transmitter at PER_HOST_USART_EMPTY when empty. The character moves
+ * through the data and shift register (TXE, TC) and arrives one character time
+ * later at the receiver (RXNE, ORE when RXNE was still set). One character time
+ * without a new one sets IDLE. DMAT and DMAR request data items of the link
+ * streams from the DMA model (per_host_dma_f4.h).
+ *
+ * The model runs only in its functions:
+ * per_host_usart_run()     advances the model time and moves the characters
+ *
+ * The interrupt callback is called when a flag with its interrupt enabled
+ * is set, like the NVIC would. A DR read is not visible on the host, so the
+ * callback of a receiver with RXNEIE or IDLEIE set is taken as the DR read of
+ * the handler, polling software clears RXNE with per_usart_rdclr_rxne().
+ *
+ * Limitations:
+ * A USART is either transmitter or receiver of links, not both, because DR
+ * is one register on the host. Parity, noise, break, hardware flow control
+ * and the synchronous, LIN, IrDA and smartcard modes are not modelled.
+ */
+
+#ifndef per_host_usart_f4_h_
+#define per_host_usart_f4_h_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "per_host_dma_f4.h"
+#include "per_usart_f4.h"
+
+/// Transmitter DR value of the model when the data register is empty, a software write of a 9 bit character
+/// replaces all of it, a DMA write only the low part, so the model reads DR itself after its DMA requests
+#define PER_HOST_USART_EMPTY (0xFFFFFFFFu)
+
+/// Maximum number of links
+#define PER_HOST_USART_LINKS (4)
+
+/// Serial line between the transmitter of one USART and the receiver of an other one
+typedef struct
+{
+    const per_usart_t* Tx; ///< Transmitting USART
+    const per_usart_t* Rx; ///< Receiving USART
+    const per_dma_stream_t* TxDma; ///< Stream that serves DMAT of the transmitter, 0 for none
+    const per_dma_stream_t* RxDma; ///< Stream that serves DMAR of the receiver, 0 for none
+    uint32_t Freq; ///< USART clock in Hz, the transmitter BRR is relative to it
+} per_host_usart_link_t;
+
+void per_host_usart_reset(void);
+
+bool per_host_usart_connect(const per_host_usart_link_t* link);
+
+uint64_t per_host_usart_char_ns(const per_host_usart_link_t* link);
+
+uint64_t per_host_usart_run(uint64_t ns);
+
+uint64_t per_host_usart_time(void);
+
+void per_host_usart_set_irq(void (*irq)(const per_usart_t* usart));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // per_host_usart_f4_h_
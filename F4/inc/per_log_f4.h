@@ -33,6 +33,11 @@ extern "C" {
 
 #include "per_dep.h"
 
+/// Number of events in the log ring, must be a power of two
+#ifndef PER_LOG_RING_SIZE
+#define PER_LOG_RING_SIZE 16
+#endif
+
 /// LOG peripheral enumeration
 typedef enum
 {
@@ -148,23 +153,131 @@ typedef enum
     PER_LOG_UART,  ///< UART
     PER_LOG_USART, ///< USART
     PER_LOG_WWDG,  ///< WWDG
+    PER_LOG_END,   ///< Number of peripherals
 } per_log_e;
 
+/// Number of error offsets (event % PER_LOG_MULT) counted per peripheral, 0 (default) removes the histogram.
+/// Offsets of this value and up are counted together in the overflow column PER_LOG_HIST_EVENTS.
+/// 26 covers all the error offsets of the library, the largest is 25 (RCC).
+#ifndef PER_LOG_HIST_EVENTS
+#define PER_LOG_HIST_EVENTS 0
+#endif
+
+/// Binary log record start marker
+#define PER_LOG_RECORD_SYNC ((uint16_t)0x5AA5)
+
+/// Binary log record, 16 bytes little endian, decoded on the host by tools/per_log_decode.py
+typedef struct
+{
+    uint16_t sync; //!< PER_LOG_RECORD_SYNC
+    uint16_t peripheral; //!< Peripheral number, per_log_e
+    uint32_t event; //!< Event number
+    uint32_t value; //!< Value
+    uint32_t time; //!< Time stamp
+} per_log_record_t;
+
+#if PER_LOG_HIST_EVENTS > 0
+/// Error histogram, number of events per peripheral and error offset, the last column counts the higher offsets
+typedef uint32_t per_log_hist_t[PER_LOG_END][PER_LOG_HIST_EVENTS + 1];
+#endif
+
+/// LOG severity level
+typedef enum
+{
+    PER_LOG_LEVEL_OFF = 0, ///< No logging
+    PER_LOG_LEVEL_ERR = 1, ///< Errors
+} per_log_level_e;
+
+/// Compile time severity level, events above the level are removed
+#ifndef PER_LOG_LEVEL
+#define PER_LOG_LEVEL PER_LOG_LEVEL_ERR
+#endif
+
+/// Compile time peripheral filter, define PER_LOG_FILTER and the masks.
+/// Bit n of PER_LOG_MASK_m enables the per_log_e value (m * 32 + n), the default masks enable all.
+#ifdef PER_LOG_FILTER
+#ifndef PER_LOG_MASK_0
+#define PER_LOG_MASK_0 UINT32_MAX
+#endif
+#ifndef PER_LOG_MASK_1
+#define PER_LOG_MASK_1 UINT32_MAX
+#endif
+#ifndef PER_LOG_MASK_2
+#define PER_LOG_MASK_2 UINT32_MAX
+#endif
+#ifndef PER_LOG_MASK_3
+#define PER_LOG_MASK_3 UINT32_MAX
+#endif
+
+/// The four masks cover 128 peripherals, a higher per_log_e value would alias onto a lower bit
+_Static_assert(PER_LOG_END <= 128, "PER_LOG_END exceeds the PER_LOG_MASK_0..3 bits");
+#endif
+
 typedef struct
 {
     per_log_e peripheral;  //!< Last error peripheral number
     uint32_t event;  //!< Last error event number
     uint32_t value;  //!< Last error value
+    uint32_t time;  //!< Last error time stamp, counter value of the clock source
 } per_log_event_t;
 
-void per_log_err(per_log_e per, uint_fast32_t ev, uint_fast32_t val);
+void per_log_put(per_log_e per, uint_fast32_t ev, uint_fast32_t val);
+
+uint32_t per_log_time(void);
+
+/// Binary log record encode, four stores that can go directly to a transmit buffer
+static per_inline void per_log_encode(per_log_record_t* rec, per_log_e per, uint_fast32_t ev, uint_fast32_t val, uint32_t time)
+{
+    rec->sync = PER_LOG_RECORD_SYNC;
+    rec->peripheral = (uint16_t)per;
+    rec->event = (uint32_t)ev;
+    rec->value = (uint32_t)val;
+    rec->time = time;
+}
+
+/// Logging is enabled for the peripheral, folds to a constant for a constant peripheral
+static per_inline bool per_log_enabled(per_log_e per)
+{
+#ifdef PER_LOG_FILTER
+    const uint32_t mask = (per < 32) ? (uint32_t)(PER_LOG_MASK_0) :
+                          (per < 64) ? (uint32_t)(PER_LOG_MASK_1) :
+                          (per < 96) ? (uint32_t)(PER_LOG_MASK_2) : (uint32_t)(PER_LOG_MASK_3);
+    return (PER_LOG_LEVEL >= PER_LOG_LEVEL_ERR) && (((mask >> (per & 31)) & 1) != 0);
+#else
+    (void)per;
+    return PER_LOG_LEVEL >= PER_LOG_LEVEL_ERR;
+#endif
+}
+
+/// Logging peripheral error event with value, removed at compile time for disabled peripherals
+static per_inline void per_log_err(per_log_e per, uint_fast32_t ev, uint_fast32_t val)
+{
+    if (per_log_enabled(per))
+    {
+        per_log_put(per, ev, val);
+    }
+}
 
 void per_log_set_callback(void (*fct)(per_log_e per, uint_fast32_t ev, uint_fast32_t val));
 
 void per_log_clr_callback(void);
 
+void per_log_set_clock(const volatile uint32_t* counter);
+
+void per_log_clr_clock(void);
+
 uint32_t per_log_get(per_log_event_t* event);
 
+uint_fast32_t per_log_drain(per_log_event_t* events, uint_fast32_t max);
+
+uint32_t per_log_dropped(void);
+
+#if PER_LOG_HIST_EVENTS > 0
+uint32_t per_log_hist_get(per_log_e per, uint_fast32_t ev);
+
+void per_log_hist_snapshot(per_log_hist_t* hist, bool reset);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -288,14 +288,14 @@ typedef struct
 /// RCC One read and write enable bit get
 static per_inline bool per_rcc_en1(const per_rcc_en1_t* self)
 {
-    return self->Rw.Bit8 != PER_BIT_0;
+    return PER_BIT_BB_GET(&self->Rw) != PER_BIT_0;
 }
 
 /// RCC One read and write enable bit set
 static per_inline void per_rcc_en1_set(per_rcc_en1_t* self, bool val)
 {
-    self->Rw.Bit8 = (uint_fast8_t)val; // Cast is fast
-    val = self->Rw.Bit8 != PER_BIT_0;  // Wait read back
+    PER_BIT_BB_SET(&self->Rw, (uint_fast8_t)val); // Cast is fast
+    val = PER_BIT_BB_GET(&self->Rw) != PER_BIT_0;  // Wait read back
 }
 
 typedef struct
@@ -502,7 +502,7 @@ static per_inline void per_spi_set_dr(const per_spi_t* const spi, uint16_t dr)
 }
 
 /// SPI address Data register
-static per_inline volatile uint_fast16_t* per_spi_addr_dr(const per_spi_t* const spi)
+static per_inline volatile per_bit_fast16_t* per_spi_addr_dr(const per_spi_t* const spi)
 {
     return &PER_BIT_BIT_BAND_TO_REG(&spi->Per->Dr)->Reg16;
 }
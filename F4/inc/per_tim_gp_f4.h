@@ -2352,6 +2352,17 @@ static per_inline void per_tim_gp_32_set_cnt(const per_tim_gp_t* const tim, uint
     per_bit_rw32_reg_set(&tim->Per->Size32.Cnt, val);
 }
 
+/// TIM_GP 32bit Counter register address, for example as per_log time stamp source
+static per_inline const volatile uint32_t* per_tim_gp_32_addr_cnt(const per_tim_gp_t* const tim)
+{
+    if (tim->Size != PER_TIM_GP_SIZE_32)
+    {
+        per_dep_err_unsupported();
+    }
+
+    return &PER_BIT_BIT_BAND_TO_REG(&tim->Per->Size32.Cnt)->Reg32;
+}
+
 /// TIM_GP 32bit Auto-reload
 static per_inline uint_fast32_t per_tim_gp_32_arr(const per_tim_gp_t* const tim)
 {
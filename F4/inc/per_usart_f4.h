@@ -50,7 +50,15 @@
  * Convenience functions:
  * per_usart_set_div(const per_usart_t* const usart, uint_fast32_t fract, uint_fast32_t mant)
  * per_usart_set_baudrate(const per_usart_t* const usart, uint_fast32_t rate)
+ * per_usart_set_baudrate_const(const per_usart_t* const usart, uint_fast32_t freq, uint_fast32_t rate, bool over8)
+ * per_usart_set_baud(const per_usart_t* const usart, const per_usart_baud_t* baud)
+ * per_usart_set_baud_table(const per_usart_t* const usart, const per_usart_baud_t* table, uint_fast8_t num, uint_fast32_t rate)
  * per_usart_flag(const per_usart_t* const usart)
+ *
+ * With a constant clock and baud rate the BRR value is computed at compile time:
+ * per_usart_set_baudrate_const(per_usart_3(), 42000000, 115200, false);
+ * fails to compile when the baud rate error exceeds PER_USART_BAUD_TOL (ppm). A
+ * table of PER_USART_BAUD() entries switches between rates without a division.
  */
 
 #ifndef per_usart_f4_h_
@@ -88,7 +96,39 @@ extern "C" {
 #define PER_UART_8  ((per_usart_per_t* const)PER_BIT_REG_TO_BIT_BAND(PER_ADDR_APB1 + (uintptr_t)0x7C00))
 
 /// USART maximum value for DR (9 bit)
-#define PER_USART_DR_MAX PER_BIT_MAX(5)
+#define PER_USART_DR_MAX PER_BIT_MAX(9)
+
+/// USART maximum baud rate error of the compile time BRR values in ppm
+#ifndef PER_USART_BAUD_TOL
+#define PER_USART_BAUD_TOL (10000)
+#endif
+
+/// USART USARTDIV times the over-sampling of a clock and baud rate, rounded
+#define PER_USART_BRR_DIV(FREQ, RATE) (((uint32_t)(FREQ) + ((uint32_t)(RATE) / 2)) / (uint32_t)(RATE))
+
+/// USART BRR value of a clock and baud rate, with over-sampling by 8 the fraction is 3 bits
+#define PER_USART_BRR(FREQ, RATE, OVER8) ((OVER8) ? \
+    (((PER_USART_BRR_DIV(FREQ, RATE) & ~(uint32_t)7) << 1) | (PER_USART_BRR_DIV(FREQ, RATE) & (uint32_t)7)) : \
+    PER_USART_BRR_DIV(FREQ, RATE))
+
+/// USART baud rate error of the BRR value in ppm
+#define PER_USART_BRR_PPM(FREQ, RATE) ((uint32_t)((((uint64_t)PER_USART_BRR_DIV(FREQ, RATE) * (RATE) > (FREQ)) ? \
+    ((uint64_t)PER_USART_BRR_DIV(FREQ, RATE) * (RATE) - (FREQ)) : ((FREQ) - (uint64_t)PER_USART_BRR_DIV(FREQ, RATE) * (RATE))) * \
+    1000000 / ((uint64_t)PER_USART_BRR_DIV(FREQ, RATE) * (RATE))))
+
+/// USART the baud rate is reachable: mantissa 1 to 4095 and the error within PER_USART_BAUD_TOL
+#define PER_USART_BRR_VALID(FREQ, RATE, OVER8) \
+    ((PER_USART_BRR_DIV(FREQ, RATE) >= ((OVER8) ? 8u : 16u)) && \
+     (PER_USART_BRR_DIV(FREQ, RATE) < ((OVER8) ? 8u : 16u) * 4096u) && \
+     (PER_USART_BRR_PPM(FREQ, RATE) <= PER_USART_BAUD_TOL))
+
+/// USART baud rate table entry of a constant clock and baud rate, does not compile when the rate is not valid
+#define PER_USART_BAUD(FREQ, RATE, OVER8) \
+    { \
+        .Rate = (RATE), \
+        .Brr = (uint16_t)(PER_USART_BRR(FREQ, RATE, OVER8) + (0 * sizeof(char[PER_USART_BRR_VALID(FREQ, RATE, OVER8) ? 1 : -1]))), \
+        .Over8 = (OVER8), \
+    }
 
 /// USART error enumeration
 typedef enum
@@ -109,6 +149,7 @@ typedef enum
     PER_USART_SET_PSC_IRDA_MAX_ERR, ///< PSC data invalid value IrDA
     PER_USART_SET_PSC_SC_MAX_ERR,   ///< PSC data invalid value SmartCard SC
     PER_USART_SET_GT_MAX_ERR,       ///< GT data invalid value
+    PER_USART_SIZE_ERR,             ///< Transfer size of 0 bytes
 } per_usart_error_e;
 
 /// USART Status register flags
@@ -119,11 +160,11 @@ typedef enum
     PER_USART_SR_NF    = 0b000000000100, ///< Noise detected flag
     PER_USART_SR_ORE   = 0b000000001000, ///< Overrun error
     PER_USART_SR_IDLE  = 0b000000010000, ///< IDLE line detected
-    PER_USART_SR_RXNE  = 0b000001000000, ///< Read data register not empty
-    PER_USART_SR_TC    = 0b000010000000, ///< Transmission complete
-    PER_USART_SR_TXE   = 0b000100000000, ///< Transmit data register empty
-    PER_USART_SR_LBD   = 0b001000000000, ///< LIN break detection flag
-    PER_USART_SR_CTS   = 0b010000000000, ///< CTS flag
+    PER_USART_SR_RXNE  = 0b000000100000, ///< Read data register not empty
+    PER_USART_SR_TC    = 0b000001000000, ///< Transmission complete
+    PER_USART_SR_TXE   = 0b000010000000, ///< Transmit data register empty
+    PER_USART_SR_LBD   = 0b000100000000, ///< LIN break detection flag
+    PER_USART_SR_CTS   = 0b001000000000, ///< CTS flag
     PER_USART_SR_CLEAR = PER_USART_SR_RXNE | ///< Clear flags
                          PER_USART_SR_TC |
                          PER_USART_SR_LBD |
@@ -265,6 +306,14 @@ typedef struct
     const bool Uart;              ///< UART type
 } per_usart_t;
 
+/// USART baud rate setting, use PER_USART_BAUD() to fill it in at compile time
+typedef struct
+{
+    uint32_t Rate; ///< Baud rate
+    uint16_t Brr; ///< BRR value, mantissa and fraction
+    bool Over8; ///< Over-sampling by 8
+} per_usart_baud_t;
+
 /// USART Parity error
 static per_inline bool per_usart_pe(const per_usart_t* const usart)
 {
@@ -391,7 +440,7 @@ static per_inline bool per_usart_set_dr(const per_usart_t* const usart, uint16_t
 }
 
 /// USART address Data value register
-static per_inline volatile uint_fast16_t* per_usart_addr_dr(const per_usart_t* const usart)
+static per_inline volatile per_bit_fast16_t* per_usart_addr_dr(const per_usart_t* const usart)
 {
     return &PER_BIT_BIT_BAND_TO_REG(&usart->Per->Dr)->Reg16;
 }
@@ -1111,6 +1160,47 @@ static per_inline bool per_usart_set_baudrate(const per_usart_t* const usart, ui
     return per_usart_set_div(usart, fract, mant);
 }
 
+/// USART Set a baud rate setting, over-sampling and BRR, without computation.
+/// Over-sampling can only be changed while the USART is disabled.
+static per_inline void per_usart_set_baud(const per_usart_t* const usart, const per_usart_baud_t* baud)
+{
+    per_usart_set_over8(usart, baud->Over8);
+    per_bit_rw16_reg_set(&usart->Per->Div, baud->Brr);
+}
+
+/// USART Set a compile time constant baud rate of a constant clock frequency, no division at run time and no
+/// over-sampling read. Does not compile when the values are not constant or the rate error exceeds PER_USART_BAUD_TOL.
+static per_inline void per_usart_set_baudrate_const(const per_usart_t* const usart, uint_fast32_t freq, uint_fast32_t rate, bool over8)
+{
+    const per_usart_baud_t baud = {.Rate = rate, .Brr = (uint16_t)PER_USART_BRR(freq, rate, over8), .Over8 = over8};
+
+    if (!PER_USART_BRR_VALID(freq, rate, over8))
+    {
+        per_dep_err_unsupported();
+    }
+
+    per_usart_set_baud(usart, &baud);
+}
+
+/// USART Set a baud rate from a table of PER_USART_BAUD() settings, for switching between a few rates at run time
+static per_inline bool per_usart_set_baud_table(const per_usart_t* const usart, const per_usart_baud_t* table, uint_fast8_t num, uint_fast32_t rate)
+{
+    while (num > 0)
+    {
+        if (table->Rate == rate)
+        {
+            per_usart_set_baud(usart, table);
+            return true;
+        }
+
+        ++table;
+        --num;
+    }
+
+    per_log_err(usart->Err, PER_USART_SET_DIV_MANT_ERR, rate);
+    return false;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,7 +33,7 @@ bool per_bit_set_bits(per_bit_bitband_t* addr, uint_fast8_t size, uint_fast16_t
 {
     while (size > 0)
     {
-        addr->Bit16 = val & (uint_fast16_t)1;
+        PER_BIT_BB_SET(addr, val & (uint_fast16_t)1);
         val >>= 1;
         ++addr;
         --size;
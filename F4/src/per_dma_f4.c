@@ -0,0 +1,367 @@
+/**
+ * @file per_dma_f4.c
+ *
+ * This file contains the Direct Memory Access (DMA) scatter-gather, memory copy engine and statistics
+ *
+ * Copyright (c) 2023 admaunaloa admaunaloa@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "per_dma_f4.h"
+
+/// Maximum number of data items of one transfer
+#define PER_DMA_NDT_MAX (0xFFFF)
+
+/// Burst of 16 bytes, the FIFO size, never crosses a 1 Kbyte boundary when 16 byte aligned
+#define PER_DMA_COPY_BURST (16)
+
+/// DMA Scatter-gather interrupt, starts the next segment with three stores or completes the transfer.
+/// Call from the stream interrupt with the flags of per_dma_stream_irq() or per_dma_irq().
+void per_dma_sg_irq(per_dma_sg_t* sg, per_dma_flag_e flags)
+{
+    const uint32_t start = (sg->Clock != 0) ? *sg->Clock : 0;
+
+    if (!sg->Busy)
+    {
+        return;
+    }
+
+    if ((flags & PER_DMA_FLAG_TE) != 0)
+    {
+        per_log_err(sg->Dma->Err, PER_DMA_ERR_TRANSFER, sg->Idx);
+        sg->Failed = true;
+    }
+    else if ((flags & PER_DMA_FLAG_TC) != 0)
+    {
+        const uint_fast16_t idx = sg->Idx + 1;
+
+        if (idx < sg->Num)
+        {
+            per_dma_conf_t* conf = sg->Dma->Conf;
+
+            per_bit_rw16_reg_set(&conf->Ndt, sg->Seg[idx].Ndt);
+            per_bit_rw32_reg_set(&conf->M0a, (uint32_t)(uintptr_t)sg->Seg[idx].Addr);
+            per_dma_stats_on_start(sg->Dma, sg->Seg[idx].Ndt, sg->Cr);
+            PER_BIT_BIT_BAND_TO_REG(&conf->En)->Reg32 = sg->Cr; // Start
+            sg->Idx = idx;
+
+            if (sg->Clock != 0)
+            {
+                const uint32_t gap = *sg->Clock - start;
+
+                sg->GapSum += gap;
+                sg->Gaps++;
+
+                if (gap > sg->GapMax)
+                {
+                    sg->GapMax = gap;
+                }
+            }
+
+            return;
+        }
+    }
+    else
+    {
+        return; // Not for the transfer
+    }
+
+    sg->Busy = false;
+
+    if (sg->Done != 0)
+    {
+        sg->Done(sg);
+    }
+}
+
+/// DMA Start the next part of the running job, the transfer settings follow the alignment
+static void per_dma_memcpy_chunk(per_dma_memcpy_t* eng)
+{
+    const per_dma_copy_t* job = eng->Run;
+    const uint8_t* src = job->Src + job->Off;
+    uint8_t* dest = job->Dest + job->Off;
+    const uint32_t rest = job->Size - job->Off;
+    const uintptr_t align = (uintptr_t)src | (uintptr_t)dest;
+    const per_dma_selection_t sel = {.Conf = eng->Dma->Conf, .Chan = PER_DMA_CHANNEL_0};
+    per_dma_config_t config =
+    {
+        .Sel = &sel,
+        .Dir = PER_DMA_DIR_MEM_TO_MEM,
+        .Pinc = true,
+        .Minc = true,
+        .Pl = eng->Pl,
+        .Tcie = true,
+        .Teie = true,
+        .Dmdis = true, // Memory to memory requires the FIFO
+        .Fth = PER_DMA_FTH_FULL,
+    };
+    per_dma_size_e size = PER_DMA_SIZE_BYTE;
+    uint32_t item = 1;
+
+    if (((align & 3) == 0) && (rest >= 4))
+    {
+        size = PER_DMA_SIZE_WORD;
+        item = 4;
+    }
+    else if (((align & 1) == 0) && (rest >= 2))
+    {
+        size = PER_DMA_SIZE_HALF_WORD;
+        item = 2;
+    }
+
+    uint32_t chunk = rest - (rest % item); // The tail is a next chunk with smaller items
+
+    if (chunk > (PER_DMA_NDT_MAX * item))
+    {
+        chunk = PER_DMA_NDT_MAX * item;
+    }
+
+    if (((align % PER_DMA_COPY_BURST) == 0) && (chunk >= PER_DMA_COPY_BURST))
+    {
+        const per_dma_burst_e burst = (item == 4) ? PER_DMA_BURST_INCR_4 : (item == 2) ? PER_DMA_BURST_INCR_8 : PER_DMA_BURST_INCR_16;
+
+        chunk -= chunk % PER_DMA_COPY_BURST; // Only complete bursts
+        config.Pburst = burst;
+        config.Mburst = burst;
+    }
+
+    config.Psize = size;
+    config.Msize = size;
+    eng->Chunk = chunk;
+    (void)per_dma_stream_irq(eng->Dma); // Clear the flags of the previous transfer
+    per_dma_write(eng->Dma, per_dma_config_cr(&config) | 1, per_dma_config_fcr(&config), (uint16_t)(chunk / item),
+                  (uint_fast32_t)(uintptr_t)src, (uint_fast32_t)(uintptr_t)dest);
+}
+
+/// DMA Start the oldest waiting job, or idle when there is none
+static void per_dma_memcpy_next(per_dma_memcpy_t* eng)
+{
+    per_dma_copy_t* job = 0;
+
+    if (eng->Tail != eng->Head)
+    {
+        job = eng->Queue[eng->Tail & (PER_DMA_COPY_QUEUE - 1)];
+        per_dep_barrier();
+        eng->Tail = eng->Tail + 1;
+    }
+
+    eng->Run = job;
+
+    if (job != 0)
+    {
+        per_dma_memcpy_chunk(eng);
+    }
+}
+
+/// DMA Memory copy engine initialise on a DMA2 stream, DMA1 can not access memory to memory
+bool per_dma_memcpy_init(per_dma_memcpy_t* eng, const per_dma_stream_t* const dma, per_dma_pl_e pl)
+{
+    if ((dma->Err < PER_LOG_DMA_2_STREAM_0) || (dma->Err > PER_LOG_DMA_2_STREAM_7))
+    {
+        per_log_err(dma->Err, PER_DMA_ERR_CONFIG, 0);
+        return false;
+    }
+
+    eng->Dma = dma;
+    eng->Pl = pl;
+    eng->Head = 0;
+    eng->Tail = 0;
+    eng->Run = 0;
+    eng->Chunk = 0;
+
+    return true;
+}
+
+/// DMA Memory copy queue a job, it starts directly when the engine is idle.
+/// Completion is signalled by done() from the interrupt and by job->Busy becoming false.
+/// Jobs are queued from one context, the interrupt of the stream must call per_dma_memcpy_irq().
+bool per_dma_memcpy_async(per_dma_memcpy_t* eng, per_dma_copy_t* job, void* dest, const void* src, uint32_t size, void (*done)(per_dma_copy_t* job))
+{
+    job->Dest = (uint8_t*)dest;
+    job->Src = (const uint8_t*)src;
+    job->Size = size;
+    job->Off = 0;
+    job->Done = done;
+    job->Failed = false;
+
+    if (size == 0)
+    {
+        job->Busy = false;
+
+        if (done != 0)
+        {
+            done(job);
+        }
+
+        return true;
+    }
+
+    if ((eng->Head - eng->Tail) >= PER_DMA_COPY_QUEUE)
+    {
+        per_log_err(eng->Dma->Err, PER_DMA_ERR_BUSY, size);
+        return false;
+    }
+
+    job->Busy = true;
+    eng->Queue[eng->Head & (PER_DMA_COPY_QUEUE - 1)] = job;
+    per_dep_barrier();
+    eng->Head = eng->Head + 1;
+
+    if (eng->Run == 0) // Idle, no interrupt can start the job
+    {
+        per_dma_memcpy_next(eng);
+    }
+
+    return true;
+}
+
+/// DMA Memory copy interrupt, continues the job or completes it and starts the next one
+void per_dma_memcpy_irq(per_dma_memcpy_t* eng)
+{
+    const per_dma_flag_e flags = per_dma_stream_irq(eng->Dma);
+    per_dma_copy_t* job = eng->Run;
+
+    if (job == 0)
+    {
+        return;
+    }
+
+    if ((flags & PER_DMA_FLAG_TE) != 0)
+    {
+        per_log_err(eng->Dma->Err, PER_DMA_ERR_TRANSFER, job->Off);
+        job->Failed = true;
+    }
+    else if ((flags & PER_DMA_FLAG_TC) != 0)
+    {
+        job->Off += eng->Chunk;
+
+        if (job->Off < job->Size)
+        {
+            per_dma_memcpy_chunk(eng);
+            return;
+        }
+    }
+    else
+    {
+        return; // Not for the job
+    }
+
+    job->Busy = false;
+
+    if (job->Done != 0)
+    {
+        job->Done(job);
+    }
+
+    per_dma_memcpy_next(eng);
+}
+
+#ifdef PER_DMA_STATS
+static per_dma_stats_t stats[PER_DMA_STATS_MAX]; //!< Statistics per stream
+static volatile uint32_t stats_seq; //!< Number of statistics updates, for a consistent snapshot
+static const volatile uint32_t stats_clock_none; //!< Time stamp source when there is no clock
+static const volatile uint32_t* stats_clock = &stats_clock_none; //!< Time stamp counter register
+
+/// DMA Statistics start of a transfer of size bytes
+void per_dma_stats_start(uint_fast8_t idx, uint32_t size)
+{
+    stats[idx].Start = *stats_clock;
+    stats[idx].Size = size;
+    ++stats_seq;
+}
+
+/// DMA Statistics of the flags of a stream, a transfer complete restarts the time for circular mode
+void per_dma_stats_flags(uint_fast8_t idx, uint32_t flags)
+{
+    per_dma_stats_t* st = &stats[idx];
+
+    if ((flags & (PER_DMA_FLAG_TE | PER_DMA_FLAG_DME | PER_DMA_FLAG_FE)) != 0)
+    {
+        st->Errors++;
+    }
+
+    if ((flags & PER_DMA_FLAG_TC) != 0)
+    {
+        const uint32_t now = *stats_clock;
+        const uint32_t time = now - st->Start;
+
+        st->Transfers++;
+        st->Bytes += st->Size;
+        st->Busy += time;
+
+        if (time > st->Max)
+        {
+            st->Max = time;
+        }
+
+        st->Start = now;
+    }
+
+    ++stats_seq;
+}
+
+/// DMA Statistics time stamp source set, a free running counter register such as DWT_CYCCNT
+void per_dma_stats_set_clock(const volatile uint32_t* counter)
+{
+    stats_clock = (counter != 0) ? counter : &stats_clock_none;
+}
+
+/// DMA Statistics counter read and clear in one exclusive access, an update in between makes the store fail
+static uint32_t per_dma_stats_take(volatile uint32_t* cnt)
+{
+    uint32_t val;
+
+    do
+    {
+        val = per_dep_ldrex(cnt);
+    }
+    while (per_dep_strex(0, cnt) != 0);
+
+    return val;
+}
+
+/// DMA Statistics copy of all streams, consistent even when interrupted. With reset each counter is cleared
+/// in the same exclusive access as it is read, so no update gets lost, but an update during the snapshot can
+/// be in some counters of this copy and in the others of the next one.
+void per_dma_stats_snapshot(per_dma_stats_t dest[PER_DMA_STATS_MAX], bool reset)
+{
+    uint32_t seq;
+    uint_fast8_t idx;
+
+    do
+    {
+        seq = stats_seq;
+        per_mem_copy(dest, stats, sizeof(stats));
+    }
+    while (seq != stats_seq);
+
+    idx = 0;
+
+    while (reset && (idx < PER_DMA_STATS_MAX))
+    {
+        dest[idx].Transfers = per_dma_stats_take(&stats[idx].Transfers);
+        dest[idx].Bytes = per_dma_stats_take(&stats[idx].Bytes);
+        dest[idx].Errors = per_dma_stats_take(&stats[idx].Errors);
+        dest[idx].Busy = per_dma_stats_take(&stats[idx].Busy);
+        dest[idx].Max = per_dma_stats_take(&stats[idx].Max);
+        ++idx;
+    }
+}
+#endif
@@ -0,0 +1,288 @@
+/**
+ * @file per_host_dma_f4.c
+ *
+ * This file contains the host behavioural model of the DMA controllers
+ *
+ * Copyright (c) 2023 admaunaloa admaunaloa@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef PER_HOST
+
+#include "per_host_dma_f4.h"
+
+/// Number of DMA controllers
+#define PER_HOST_DMA_MAX (2)
+
+/// Model state of a stream
+typedef struct
+{
+    bool Run; ///< Enabled as seen by the model
+    uint16_t Ndt; ///< Number of data items at the start
+    uint32_t Pos; ///< Number of data items done since the start or reload
+    bool (*Req)(void* ctx); ///< Peripheral request callback
+    void* Ctx; ///< Peripheral request callback context
+} per_host_dma_stream_t;
+
+static per_host_dma_stream_t streams[PER_HOST_DMA_MAX][PER_DMA_STREAM_MAX]; //!< Stream states
+static void (*irq_cb)(per_dma_t* dma, per_dma_stream_e str); //!< Interrupt callback
+
+/// Stream position in the status and clear registers
+static const uint8_t shift[PER_DMA_STREAM_MAX] = {0, 6, 16, 22, 0, 6, 16, 22};
+
+/// DMA controller of an index
+static per_dma_t* per_host_dma_ctrl(uint_fast8_t idx)
+{
+    return (idx == 0) ? PER_DMA_1_BB : PER_DMA_2_BB;
+}
+
+/// Status register word of a stream, DMA_LISR or DMA_HISR, the clear registers follow at +2
+static volatile uint32_t* per_host_dma_isr(per_dma_t* dma, uint_fast8_t str)
+{
+    return &PER_BIT_BIT_BAND_TO_REG(&dma->Isr0)->Reg32 + (str / 4);
+}
+
+/// Host pointer of a target address
+static uint8_t* per_host_dma_mem(uint32_t addr)
+{
+    return (uint8_t*)per_host_ptr(addr);
+}
+
+/// Set a flag of a stream and call the interrupt when it is enabled
+static void per_host_dma_flag(per_dma_t* dma, uint_fast8_t str, per_dma_flag_e flag, bool ie)
+{
+    *per_host_dma_isr(dma, str) |= (uint32_t)flag << shift[str];
+
+    if (ie && (irq_cb != 0))
+    {
+        irq_cb(dma, (per_dma_stream_e)str);
+        per_host_dma_sync(); // The interrupt cleared flags and changed streams
+    }
+}
+
+/// Check the data sizes of a stream at the start. In direct mode MSIZE is not used. With the FIFO the
+/// memory side packs or unpacks the peripheral items, the model only supports it on an incrementing memory
+/// address, where the packed bytes are the peripheral items one after the other, and with NDTR a multiple
+/// of the packing.
+static bool per_host_dma_sizes(uint_fast8_t idx, uint_fast8_t str)
+{
+    per_dma_conf_t* conf = &per_host_dma_ctrl(idx)->Stream[str];
+    const uint_fast16_t psize = per_bit_rw2(&conf->Psize);
+    const uint_fast16_t msize = per_bit_rw2(&conf->Msize);
+    const bool fifo = per_bit_rw1(&conf->Dmdis) || (per_bit_rw2(&conf->Dir) == PER_DMA_DIR_MEM_TO_MEM);
+
+    if (!fifo || (msize == psize))
+    {
+        return true;
+    }
+
+    if (!per_bit_rw1(&conf->Minc) || ((msize > psize) && ((per_bit_rw16_reg(&conf->Ndt) % (1u << (msize - psize))) != 0)))
+    {
+        per_log_err((per_log_e)(((idx == 0) ? PER_LOG_DMA_1_STREAM_0 : PER_LOG_DMA_2_STREAM_0) + str), PER_DMA_ERR_CONFIG,
+                    PER_BIT_BIT_BAND_TO_REG(&conf->En)->Reg32); // DMA_SxCR
+        return false;
+    }
+
+    return true;
+}
+
+/// Apply the stream enable changes and then the flag clear writes of the software. The driver calls it
+/// after each DMA_xIFCR write, so the clear follows the flags the stop of a stream sets.
+void per_host_dma_sync(void)
+{
+    uint_fast8_t idx = 0;
+
+    while (idx < PER_HOST_DMA_MAX)
+    {
+        per_dma_t* dma = per_host_dma_ctrl(idx);
+        volatile uint32_t* isr = &PER_BIT_BIT_BAND_TO_REG(&dma->Isr0)->Reg32;
+        uint_fast8_t str = 0;
+
+        while (str < PER_DMA_STREAM_MAX)
+        {
+            per_host_dma_stream_t* st = &streams[idx][str];
+            per_dma_conf_t* conf = &dma->Stream[str];
+            const bool en = per_bit_rw1(&conf->En);
+
+            if (en && !st->Run && !per_host_dma_sizes(idx, str)) // Not supported, the stream does not start
+            {
+                per_bit_rw1_set(&conf->En, false);
+            }
+            else if (en && !st->Run) // Started
+            {
+                st->Run = true;
+                st->Ndt = (uint16_t)per_bit_rw16_reg(&conf->Ndt);
+                st->Pos = 0;
+            }
+            else if (!en && st->Run) // Stopped by the software, the transfer complete flag is set
+            {
+                st->Run = false;
+                *per_host_dma_isr(dma, str) |= (uint32_t)PER_DMA_FLAG_TC << shift[str];
+            }
+
+            ++str;
+        }
+
+        isr[0] &= ~isr[2]; // DMA_LIFCR clears DMA_LISR
+        isr[1] &= ~isr[3]; // DMA_HIFCR clears DMA_HISR
+        isr[2] = 0;
+        isr[3] = 0;
+        ++idx;
+    }
+}
+
+/// Move one data item of a stream
+static void per_host_dma_item(uint_fast8_t idx, uint_fast8_t str)
+{
+    per_host_dma_stream_t* st = &streams[idx][str];
+    per_dma_t* dma = per_host_dma_ctrl(idx);
+    per_dma_conf_t* conf = &dma->Stream[str];
+    const per_dma_dir_e dir = (per_dma_dir_e)per_bit_rw2(&conf->Dir);
+    const uint32_t size = (uint32_t)1 << per_bit_rw2(&conf->Psize); // Peripheral data item, packed on the memory side
+    const uint32_t pstep = per_bit_rw1(&conf->Pinc) ? (per_bit_rw1(&conf->Pincos) ? 4 : size) : 0;
+    const uint32_t mstep = per_bit_rw1(&conf->Minc) ? size : 0;
+    const bool dbm = per_bit_rw1(&conf->Dbm);
+    const uint32_t maddr = (dbm && per_bit_rw1(&conf->Ct)) ? per_bit_rw32_reg(&conf->M1a) : per_bit_rw32_reg(&conf->M0a);
+    uint8_t* per = per_host_dma_mem(per_bit_rw32_reg(&conf->Par) + (st->Pos * pstep));
+    uint8_t* mem = per_host_dma_mem(maddr + (st->Pos * mstep));
+    uint16_t ndt = (uint16_t)per_bit_rw16_reg(&conf->Ndt);
+
+    if (dir == PER_DMA_DIR_PER_TO_MEM)
+    {
+        per_mem_copy(mem, per, size);
+    }
+    else if (dir == PER_DMA_DIR_MEM_TO_PER)
+    {
+        per_mem_copy(per, mem, size);
+    }
+    else // Memory to memory, PAR is the source and M0AR the destination
+    {
+        per_mem_copy(per_host_dma_mem(maddr + (st->Pos * size)), per_host_dma_mem(per_bit_rw32_reg(&conf->Par) + (st->Pos * size)), size);
+    }
+
+    st->Pos++;
+    per_bit_rw16_reg_set(&conf->Ndt, --ndt);
+
+    if (st->Pos == (uint32_t)(st->Ndt / 2))
+    {
+        per_host_dma_flag(dma, str, PER_DMA_FLAG_HT, per_bit_rw1(&conf->Htie));
+    }
+
+    if (ndt == 0)
+    {
+        if (dbm || per_bit_rw1(&conf->Circ)) // Reload
+        {
+            per_bit_rw16_reg_set(&conf->Ndt, st->Ndt);
+            st->Pos = 0;
+
+            if (dbm)
+            {
+                per_bit_rw1_set(&conf->Ct, !per_bit_rw1(&conf->Ct));
+            }
+        }
+        else
+        {
+            st->Run = false;
+            per_bit_rw1_set(&conf->En, false);
+        }
+
+        per_host_dma_flag(dma, str, PER_DMA_FLAG_TC, per_bit_rw1(&conf->Tcie));
+    }
+}
+
+/// Reset the model, the registers are reset with per_host_clear()
+void per_host_dma_reset(void)
+{
+    memset(streams, 0, sizeof(streams));
+    irq_cb = 0;
+}
+
+/// Advance the active streams, each tick every memory to memory stream and every peripheral stream with
+/// an active request moves one data item. Returns the number of data items moved.
+uint_fast32_t per_host_dma_tick(uint_fast32_t ticks)
+{
+    uint_fast32_t items = 0;
+
+    while (ticks > 0)
+    {
+        uint_fast8_t idx = 0;
+
+        per_host_dma_sync();
+
+        while (idx < PER_HOST_DMA_MAX)
+        {
+            uint_fast8_t str = 0;
+
+            while (str < PER_DMA_STREAM_MAX)
+            {
+                per_host_dma_stream_t* st = &streams[idx][str];
+                per_dma_conf_t* conf = &per_host_dma_ctrl(idx)->Stream[str];
+
+                if (st->Run && ((per_bit_rw2(&conf->Dir) == PER_DMA_DIR_MEM_TO_MEM) || ((st->Req != 0) && st->Req(st->Ctx))))
+                {
+                    per_host_dma_item(idx, str);
+                    items++;
+                }
+
+                ++str;
+            }
+
+            ++idx;
+        }
+
+        --ticks;
+    }
+
+    return items;
+}
+
+/// Peripheral requests of a stream, moves up to items data items. Returns the number of data items moved.
+uint_fast32_t per_host_dma_request(per_dma_t* dma, per_dma_stream_e str, uint_fast32_t items)
+{
+    const uint_fast8_t idx = (dma == PER_DMA_1_BB) ? 0 : 1;
+    uint_fast32_t done = 0;
+
+    per_host_dma_sync();
+
+    while ((done < items) && streams[idx][str].Run)
+    {
+        per_host_dma_item(idx, str);
+        done++;
+    }
+
+    return done;
+}
+
+/// Peripheral request callback of a stream for per_host_dma_tick(), 0 for none
+void per_host_dma_set_request(per_dma_t* dma, per_dma_stream_e str, bool (*req)(void* ctx), void* ctx)
+{
+    per_host_dma_stream_t* st = &streams[(dma == PER_DMA_1_BB) ? 0 : 1][str];
+
+    st->Req = req;
+    st->Ctx = ctx;
+}
+
+/// Interrupt callback, called for a flag with its interrupt enabled
+void per_host_dma_set_irq(void (*irq)(per_dma_t* dma, per_dma_stream_e str))
+{
+    irq_cb = irq;
+}
+
+#endif // PER_HOST
@@ -0,0 +1,80 @@
+/**
+ * @file per_host_f4.c
+ *
+ * This file contains the host register simulator functions
+ *
+ * Copyright (c) 2023 admaunaloa admaunaloa@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef PER_HOST
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // mmap() MAP_ANONYMOUS, MAP_NORESERVE and MAP_FIXED_NOREPLACE are not in ISO C
+#endif
+
+#include "per_host_f4.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+/// Map the shadow address space, called automatically before main(). Without the mapping the first register
+/// access would crash, so a failure stops the program with a message.
+__attribute__((constructor)) bool per_host_init(void)
+{
+    static bool mapped;
+
+    if (!mapped)
+    {
+        void* addr = mmap((void*)PER_HOST_BASE, PER_HOST_SIZE, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+
+        if (addr == MAP_FAILED) // Address range in use, or no memory
+        {
+            perror("per_host_init: mmap of the register shadow area");
+            abort();
+        }
+
+        if (addr != (void*)PER_HOST_BASE) // A kernel without MAP_FIXED_NOREPLACE takes it as a hint
+        {
+            munmap(addr, PER_HOST_SIZE);
+            fprintf(stderr, "per_host_init: register shadow area mapped at %p instead of %p\n", addr, (void*)PER_HOST_BASE);
+            abort();
+        }
+
+        mapped = true;
+    }
+
+    return mapped;
+}
+
+/// Reset all the shadow registers to zero, only the touched pages are released
+void per_host_clear(void)
+{
+    madvise((void*)PER_HOST_BASE, PER_HOST_SIZE, MADV_DONTNEED);
+}
+
+/// Without the DMA model there are no stream flags to update
+__attribute__((weak)) void per_host_dma_sync(void)
+{
+}
+
+#endif // PER_HOST
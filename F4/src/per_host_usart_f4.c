@@ -0,0 +1,337 @@
+/**
+ * @file per_host_usart_f4.c
+ *
+ * This file contains the host behavioural model of the USART serial lines
+ *
+ * Copyright (c) 2023 admaunaloa admaunaloa@gmail.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef PER_HOST
+
+#include "per_host_usart_f4.h"
+
+/// Model state of a link
+typedef struct
+{
+    per_host_usart_link_t Link; ///< Wiring
+    uint16_t TxSr; ///< Transmitter status flags
+    uint16_t RxSr; ///< Receiver status flags
+    bool Tdr; ///< Transmit data register full
+    uint16_t TdrVal; ///< Transmit data register
+    bool Shift; ///< Shift register busy
+    uint16_t ShiftVal; ///< Shift register
+    uint64_t Char; ///< Character time of the character in the shift register
+    uint64_t Done; ///< Time the character in the shift register arrives at the receiver
+    uint64_t Idle; ///< Time the receiver detects an idle line, 0 for none
+} per_host_usart_state_t;
+
+static per_host_usart_state_t links[PER_HOST_USART_LINKS]; //!< Link states
+static uint_fast8_t link_num; //!< Number of links
+static uint64_t now; //!< Model time in nanoseconds
+static void (*irq_cb)(const per_usart_t* usart); //!< Interrupt callback
+
+/// Peripheral request of a stream, returns the number of data items moved
+static uint_fast32_t per_host_usart_dma(const per_dma_stream_t* str)
+{
+    per_dma_t* const dma = (str->Conf < &PER_DMA_2_BB->Stream[0]) ? PER_DMA_1_BB : PER_DMA_2_BB;
+
+    return per_host_dma_request(dma, (per_dma_stream_e)(str->Conf - &dma->Stream[0]), 1);
+}
+
+/// Apply the SR writes of the software to the model flags, only the rc_w0 flags can be cleared by writing zero
+static uint16_t per_host_usart_sync(const per_usart_t* usart, uint16_t flags)
+{
+    flags &= (uint16_t)(per_bit_rw16_reg(&usart->Per->Sr) | ~(uint16_t)PER_USART_SR_CLEAR);
+    per_bit_rw16_reg_set(&usart->Per->Sr, flags);
+
+    return flags;
+}
+
+/// Call the interrupt callback of one side of a link when a flag with its interrupt enabled is set.
+/// Returns true when the callback was called.
+static bool per_host_usart_irq(per_host_usart_state_t* st, bool rx)
+{
+    const per_usart_t* const usart = rx ? st->Link.Rx : st->Link.Tx;
+    uint16_t* const flags = rx ? &st->RxSr : &st->TxSr;
+    const bool read = per_usart_rxneie(usart) || per_usart_idleie(usart); // The handler reads DR
+    bool pending;
+
+    *flags = per_host_usart_sync(usart, *flags);
+    pending = (((*flags & PER_USART_SR_TXE) != 0) && per_usart_txeie(usart)) ||
+              (((*flags & PER_USART_SR_TC) != 0) && per_usart_tcie(usart)) ||
+              (((*flags & (PER_USART_SR_RXNE | PER_USART_SR_ORE)) != 0) && per_usart_rxneie(usart)) ||
+              (((*flags & PER_USART_SR_IDLE) != 0) && per_usart_idleie(usart));
+
+    if (pending && (irq_cb != 0))
+    {
+        irq_cb(usart);
+        *flags = per_host_usart_sync(usart, *flags);
+
+        if (rx && read)
+        {
+            *flags &= (uint16_t)~(PER_USART_SR_RXNE | PER_USART_SR_ORE | PER_USART_SR_IDLE);
+            per_bit_rw16_reg_set(&usart->Per->Sr, *flags);
+        }
+    }
+
+    return pending && (irq_cb != 0);
+}
+
+/// Transmitter, a character written to DR moves to the data register
+static void per_host_usart_tdr(per_host_usart_state_t* st, uint16_t val)
+{
+    const per_usart_t* const usart = st->Link.Tx;
+
+    st->Tdr = true;
+    st->TdrVal = val;
+    per_bit_rw16_reg_set(&usart->Per->Dr, PER_HOST_USART_EMPTY);
+    st->TxSr &= (uint16_t)~(PER_USART_SR_TXE | PER_USART_SR_TC);
+    per_bit_rw16_reg_set(&usart->Per->Sr, st->TxSr);
+}
+
+/// Transmitter, takes a DR write or a DMA data item into the data register and the data register into the shift register
+static void per_host_usart_tx(per_host_usart_state_t* st)
+{
+    const per_usart_t* const usart = st->Link.Tx;
+    bool more = per_usart_ue(usart) && per_usart_te(usart);
+    bool called = false;
+
+    while (more)
+    {
+        const uint32_t dr = per_bit_rw16_reg(&usart->Per->Dr);
+
+        more = true;
+        st->TxSr = per_host_usart_sync(usart, st->TxSr);
+
+        if (!st->Tdr && (dr != PER_HOST_USART_EMPTY)) // Written by the software
+        {
+            per_host_usart_tdr(st, (uint16_t)(dr & PER_USART_DR_MAX));
+        }
+        else if (!st->Tdr && per_usart_dmat(usart) && (st->Link.TxDma != 0) && (per_host_usart_dma(st->Link.TxDma) != 0))
+        {
+            // The stream wrote a byte, or a half word with 9 data bits, over the empty marker
+            per_host_usart_tdr(st, (uint16_t)(per_bit_rw16_reg(&usart->Per->Dr) & (per_usart_m(usart) ? PER_USART_DR_MAX : 0xFF)));
+        }
+        else if (!st->Tdr && !called) // TXE interrupt, the handler can write DR
+        {
+            called = true;
+            more = per_host_usart_irq(st, false);
+        }
+        else if (st->Tdr && !st->Shift)
+        {
+            st->Shift = true;
+            st->ShiftVal = st->TdrVal;
+            st->Tdr = false;
+            st->Char = per_host_usart_char_ns(&st->Link);
+            st->Done = now + st->Char;
+            st->TxSr |= PER_USART_SR_TXE;
+            per_bit_rw16_reg_set(&usart->Per->Sr, st->TxSr);
+            called = false;
+        }
+        else
+        {
+            more = false;
+        }
+    }
+}
+
+/// Receiver, the character in the shift register arrives
+static void per_host_usart_rx(per_host_usart_state_t* st)
+{
+    const per_usart_t* const usart = st->Link.Rx;
+
+    st->Shift = false;
+
+    if (!st->Tdr) // Transmission complete
+    {
+        st->TxSr = per_host_usart_sync(st->Link.Tx, st->TxSr) | PER_USART_SR_TC;
+        per_bit_rw16_reg_set(&st->Link.Tx->Per->Sr, st->TxSr);
+        (void)per_host_usart_irq(st, false);
+    }
+
+    if (per_usart_ue(usart) && per_usart_re(usart))
+    {
+        st->RxSr = per_host_usart_sync(usart, st->RxSr);
+        st->Idle = now + st->Char;
+
+        if ((st->RxSr & PER_USART_SR_RXNE) != 0) // Not read yet, the character is lost
+        {
+            st->RxSr |= PER_USART_SR_ORE;
+        }
+        else
+        {
+            per_bit_rw16_reg_set(&usart->Per->Dr, st->ShiftVal);
+
+            if (!per_usart_dmar(usart) || (st->Link.RxDma == 0) || (per_host_usart_dma(st->Link.RxDma) == 0))
+            {
+                st->RxSr |= PER_USART_SR_RXNE; // Not read by the stream
+            }
+        }
+
+        per_bit_rw16_reg_set(&usart->Per->Sr, st->RxSr);
+        (void)per_host_usart_irq(st, true);
+    }
+}
+
+/// Receiver, one character time without a new character
+static void per_host_usart_idle(per_host_usart_state_t* st)
+{
+    const per_usart_t* const usart = st->Link.Rx;
+
+    st->Idle = 0;
+    st->RxSr = per_host_usart_sync(usart, st->RxSr) | PER_USART_SR_IDLE;
+    per_bit_rw16_reg_set(&usart->Per->Sr, st->RxSr);
+    (void)per_host_usart_irq(st, true);
+}
+
+/// Reset the model, the registers are reset with per_host_clear()
+void per_host_usart_reset(void)
+{
+    memset(links, 0, sizeof(links));
+    link_num = 0;
+    now = 0;
+    irq_cb = 0;
+}
+
+/// Add a link, after the setup of the USARTs. A USART can not be the transmitter of one link and the
+/// receiver of an other. Returns false when the link is not possible.
+bool per_host_usart_connect(const per_host_usart_link_t* link)
+{
+    per_host_usart_state_t* st;
+    uint_fast8_t idx = 0;
+
+    if ((link_num >= PER_HOST_USART_LINKS) || (link->Tx->Per == link->Rx->Per))
+    {
+        return false;
+    }
+
+    while (idx < link_num)
+    {
+        if ((links[idx].Link.Tx->Per == link->Rx->Per) || (links[idx].Link.Rx->Per == link->Tx->Per))
+        {
+            return false;
+        }
+
+        ++idx;
+    }
+
+    st = &links[link_num++];
+    memset(st, 0, sizeof(*st));
+    st->Link = *link;
+    st->TxSr = PER_USART_SR_TXE | PER_USART_SR_TC;
+    per_bit_rw16_reg_set(&link->Tx->Per->Sr, st->TxSr);
+    per_bit_rw16_reg_set(&link->Tx->Per->Dr, PER_HOST_USART_EMPTY);
+
+    return true;
+}
+
+/// Character time in nanoseconds of the transmitter setting of a link: start bit, M data bits and STOP
+uint64_t per_host_usart_char_ns(const per_host_usart_link_t* link)
+{
+    static const uint8_t stop[4] = {2, 1, 4, 3}; // Half bits per per_usart_stop_e
+    const per_usart_t* const usart = link->Tx;
+    const uint32_t brr = per_bit_rw16_reg(&usart->Per->Div);
+    const uint32_t div = per_usart_over8(usart) ? (((brr >> 4) * 8) + (brr & 0x7)) : brr; // Clocks per bit
+    const uint32_t half = (2 * (1 + (per_usart_m(usart) ? 9 : 8))) + stop[per_usart_stop(usart) & 3]; // Half bits
+
+    return (link->Freq != 0) ? (((uint64_t)div * half * 1000000000u) / (2u * (uint64_t)link->Freq)) : 0;
+}
+
+/// Advance the model time, every link applies the SR writes of the software, moves the characters written
+/// or requested by DMA and delivers them at the end of their character time. Returns the model time.
+uint64_t per_host_usart_run(uint64_t ns)
+{
+    const uint64_t end = now + ns;
+
+    while (true)
+    {
+        uint64_t next = UINT64_MAX;
+        uint_fast8_t idx = 0;
+
+        while (idx < link_num)
+        {
+            per_host_usart_state_t* st = &links[idx];
+
+            st->RxSr = per_host_usart_sync(st->Link.Rx, st->RxSr); // Flags cleared by the software
+            per_host_usart_tx(st);
+
+            if (st->Shift && (st->Done < next))
+            {
+                next = st->Done;
+            }
+
+            if ((st->Idle != 0) && (st->Idle < next))
+            {
+                next = st->Idle;
+            }
+
+            ++idx;
+        }
+
+        if (next > end)
+        {
+            break;
+        }
+
+        now = next;
+        idx = 0;
+
+        while (idx < link_num) // Arrivals first, a new character postpones the idle line
+        {
+            if (links[idx].Shift && (links[idx].Done <= now))
+            {
+                per_host_usart_rx(&links[idx]);
+            }
+
+            ++idx;
+        }
+
+        idx = 0;
+
+        while (idx < link_num)
+        {
+            if ((links[idx].Idle != 0) && (links[idx].Idle <= now))
+            {
+                per_host_usart_idle(&links[idx]);
+            }
+
+            ++idx;
+        }
+    }
+
+    now = end;
+
+    return now;
+}
+
+/// Model time in nanoseconds since the reset
+uint64_t per_host_usart_time(void)
+{
+    return now;
+}
+
+/// Interrupt callback, called for a flag with its interrupt enabled
+void per_host_usart_set_irq(void (*irq)(const per_usart_t* usart))
+{
+    irq_cb = irq;
+}
+
+#endif // PER_HOST
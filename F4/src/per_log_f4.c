@@ -26,13 +26,84 @@
 
 #include "per_log_f4.h"
 
+_Static_assert((PER_LOG_RING_SIZE & (PER_LOG_RING_SIZE - 1)) == 0, "PER_LOG_RING_SIZE must be a power of two");
+
+/// Log ring entry
+typedef struct
+{
+    per_log_event_t event; //!< Event
+    volatile uint32_t seq; //!< Position + 1 of the event when written completely
+} per_log_slot_t;
+
 static per_log_event_t last; //!< Last event
 static volatile uint32_t count; //!< Number of errors
 static void (*callback)(per_log_e per, uint_fast32_t ev, uint_fast32_t val);
+static const volatile uint32_t clock_none; //!< Time stamp source when there is no clock
+static const volatile uint32_t* clock = &clock_none; //!< Time stamp counter register
+
+static per_log_slot_t ring[PER_LOG_RING_SIZE]; //!< Event ring
+static volatile uint32_t head; //!< Ring position of the next event
+static volatile uint32_t tail; //!< Ring position of the oldest not drained event
+static volatile uint32_t dropped; //!< Number of events not stored because the ring was full
+
+#if PER_LOG_HIST_EVENTS > 0
+static volatile uint32_t hist_cnt[PER_LOG_END][PER_LOG_HIST_EVENTS + 1]; //!< Error histogram with overflow column
+#endif
+
+/// Atomic counter increment, can be interrupted
+static void per_log_inc(volatile uint32_t* cnt)
+{
+    uint32_t val;
+
+    do
+    {
+        val = per_dep_ldrex(cnt);
+    }
+    while (per_dep_strex(val + 1, cnt) != 0);
+}
+
+/// Store an event in the ring, lock-free and can be interrupted by another producer
+static void per_log_ring_put(per_log_e per, uint_fast32_t ev, uint_fast32_t val, uint32_t time)
+{
+    uint32_t pos;
+
+    do
+    {
+        pos = per_dep_ldrex(&head);
+
+        if ((pos - tail) >= PER_LOG_RING_SIZE) // Full, keep the oldest events as they show the cause
+        {
+            per_log_inc(&dropped);
+            return;
+        }
+    }
+    while (per_dep_strex(pos + 1, &head) != 0); // Reserve the slot
+
+    per_log_slot_t* slot = &ring[pos & (PER_LOG_RING_SIZE - 1)];
+    slot->event.peripheral = per;
+    slot->event.event = ev;
+    slot->event.value = val;
+    slot->event.time = time;
+    per_dep_barrier();
+    slot->seq = pos + 1; // Commit
+}
+
+#if PER_LOG_HIST_EVENTS > 0
+/// Histogram counter of a peripheral error event, unknown peripherals are counted in the PER_LOG_OK row and
+/// offsets out of the histogram in the overflow column
+static volatile uint32_t* per_log_hist_cnt(per_log_e per, uint_fast32_t ev)
+{
+    const uint_fast32_t off = ev % PER_LOG_MULT;
+    const uint_fast32_t row = ((uint_fast32_t)per < PER_LOG_END) ? (uint_fast32_t)per : PER_LOG_OK;
+
+    return &hist_cnt[row][(off < PER_LOG_HIST_EVENTS) ? off : PER_LOG_HIST_EVENTS];
+}
+#endif
 
 /// Logging peripheral error event with value, can be called from interrupt and user-space
-void per_log_err(per_log_e per, uint_fast32_t ev, uint_fast32_t val)
+void per_log_put(per_log_e per, uint_fast32_t ev, uint_fast32_t val)
 {
+    const uint32_t time = *clock; // First, as close to the event as possible
     uint32_t cnt;
 
     do
@@ -41,9 +112,16 @@ void per_log_err(per_log_e per, uint_fast32_t ev, uint_fast32_t val)
         last.peripheral = per;
         last.event = ev;
         last.value = val;
+        last.time = time;
     }
     while(cnt != count);
 
+    per_log_ring_put(per, ev, val, time);
+
+#if PER_LOG_HIST_EVENTS > 0
+    per_log_inc(per_log_hist_cnt(per, ev));
+#endif
+
     if (0 != callback)
     {
         callback(per, ev, val); // inform user
@@ -62,6 +140,25 @@ void per_log_clr_callback(void)
     callback = 0;
 }
 
+/// Logging time stamp source set, a free running counter register such as DWT_CYCCNT or TIMx_CNT of a 32 bit timer.
+/// The time stamp costs one load of the pointer and one of the counter.
+void per_log_set_clock(const volatile uint32_t* counter)
+{
+    clock = counter;
+}
+
+/// Logging time stamp source clear, the time stamps are 0
+void per_log_clr_clock(void)
+{
+    clock = &clock_none;
+}
+
+/// Logging time stamp now, for a record encoded in the callback
+uint32_t per_log_time(void)
+{
+    return *clock;
+}
+
 /// Get last logging event, is consistent even when interrupted.
 uint32_t per_log_get(per_log_event_t* ev)
 {
@@ -76,3 +173,67 @@ uint32_t per_log_get(per_log_event_t* ev)
 
     return cnt;
 }
+
+/// Move up to max of the oldest events from the ring to events, returns the number of events moved.
+/// Single consumer, an event that is still being written by an interrupted producer ends the drain.
+uint_fast32_t per_log_drain(per_log_event_t* events, uint_fast32_t max)
+{
+    uint32_t pos = tail;
+    uint_fast32_t num = 0;
+
+    while ((num < max) && (ring[pos & (PER_LOG_RING_SIZE - 1)].seq == (pos + 1)))
+    {
+        per_dep_barrier();
+        per_mem_copy(&events[num], &ring[pos & (PER_LOG_RING_SIZE - 1)].event, sizeof(*events));
+        ++pos;
+        ++num;
+    }
+
+    per_dep_barrier();
+    tail = pos; // Release the slots to the producers
+
+    return num;
+}
+
+/// Number of events that were not stored in the ring because it was full
+uint32_t per_log_dropped(void)
+{
+    return dropped;
+}
+
+#if PER_LOG_HIST_EVENTS > 0
+/// Number of events of a peripheral error, ev is the error enum value
+uint32_t per_log_hist_get(per_log_e per, uint_fast32_t ev)
+{
+    return *per_log_hist_cnt(per, ev);
+}
+
+/// Copy the error histogram, with reset each counter is cleared in the same exclusive access as it is read
+/// so no event gets lost. Can be interrupted by the logging.
+void per_log_hist_snapshot(per_log_hist_t* hist, bool reset)
+{
+    volatile uint32_t* cnt = &hist_cnt[0][0];
+    uint32_t* dst = &(*hist)[0][0];
+    uint_fast32_t num = PER_LOG_END * (PER_LOG_HIST_EVENTS + 1);
+
+    while (num > 0)
+    {
+        if (reset)
+        {
+            do
+            {
+                *dst = per_dep_ldrex(cnt);
+            }
+            while (per_dep_strex(0, cnt) != 0);
+        }
+        else
+        {
+            *dst = *cnt;
+        }
+
+        ++cnt;
+        ++dst;
+        --num;
+    }
+}
+#endif
@@ -33,20 +33,28 @@ extern "C" {
 
 #include "per_dep.h"
 
-#define PER_ADDR_FLASH            ((uintptr_t) 0x08000000) ///< FLASH (up to 2 MB) base address in the alias region
-#define PER_ADDR_CCMDATARAM       ((uintptr_t) 0x10000000) ///< CCM (core coupled memory) data RAM (64 KB) base address in the alias region
-#define PER_ADDR_SRAM1            ((uintptr_t) 0x20000000) ///< SRAM1(112 KB) base address in the alias region
-#define PER_ADDR_SRAM2            ((uintptr_t) 0x2001C000) ///< SRAM2(16 KB) base address in the alias region
-#define PER_ADDR_SRAM3            ((uintptr_t) 0x20020000) ///< SRAM3(64 KB) base address in the alias region
-#define PER_ADDR_PERIPH           ((uintptr_t) 0x40000000) ///< Peripheral base address in the alias region
-#define PER_ADDR_BKPSRAM          ((uintptr_t) 0x40024000) ///< Backup SRAM(4 KB) base address in the alias region
-#define PER_ADDR_FMC_R            ((uintptr_t) 0xA0000000) ///< FMC registers base address
-#define PER_ADDR_SRAM1_BB         ((uintptr_t) 0x22000000) ///< SRAM1 base address in the bit-band region
-#define PER_ADDR_SRAM2_BB         ((uintptr_t) 0x22380000) ///< SRAM2 base address in the bit-band region
-#define PER_ADDR_SRAM3_BB         ((uintptr_t) 0x22400000) ///< SRAM3 base address in the bit-band region
-#define PER_ADDR_PERIPH_BB        ((uintptr_t) 0x42000000) ///< Peripheral base address in the bit-band region
-#define PER_ADDR_BKPSRAM_BB       ((uintptr_t) 0x42480000) ///< Backup SRAM(4 KB) base address in the bit-band region
-#define PER_ADDR_FLASH_OTP        ((uintptr_t) 0x1FFF7800) ///< Base address of : (up to 528 Bytes) embedded FLASH OTP Area
+#ifdef PER_HOST
+#include "per_host_f4.h"
+
+#define PER_ADDR_BASE             PER_HOST_BASE ///< Host shadow address space base
+#else
+#define PER_ADDR_BASE             ((uintptr_t) 0x00000000) ///< Target address space base
+#endif
+
+#define PER_ADDR_FLASH            (PER_ADDR_BASE + (uintptr_t) 0x08000000) ///< FLASH (up to 2 MB) base address in the alias region
+#define PER_ADDR_CCMDATARAM       (PER_ADDR_BASE + (uintptr_t) 0x10000000) ///< CCM (core coupled memory) data RAM (64 KB) base address in the alias region
+#define PER_ADDR_SRAM1            (PER_ADDR_BASE + (uintptr_t) 0x20000000) ///< SRAM1(112 KB) base address in the alias region
+#define PER_ADDR_SRAM2            (PER_ADDR_BASE + (uintptr_t) 0x2001C000) ///< SRAM2(16 KB) base address in the alias region
+#define PER_ADDR_SRAM3            (PER_ADDR_BASE + (uintptr_t) 0x20020000) ///< SRAM3(64 KB) base address in the alias region
+#define PER_ADDR_PERIPH           (PER_ADDR_BASE + (uintptr_t) 0x40000000) ///< Peripheral base address in the alias region
+#define PER_ADDR_BKPSRAM          (PER_ADDR_BASE + (uintptr_t) 0x40024000) ///< Backup SRAM(4 KB) base address in the alias region
+#define PER_ADDR_FMC_R            (PER_ADDR_BASE + (uintptr_t) 0xA0000000) ///< FMC registers base address
+#define PER_ADDR_SRAM1_BB         (PER_ADDR_BASE + (uintptr_t) 0x22000000) ///< SRAM1 base address in the bit-band region
+#define PER_ADDR_SRAM2_BB         (PER_ADDR_BASE + (uintptr_t) 0x22380000) ///< SRAM2 base address in the bit-band region
+#define PER_ADDR_SRAM3_BB         (PER_ADDR_BASE + (uintptr_t) 0x22400000) ///< SRAM3 base address in the bit-band region
+#define PER_ADDR_PERIPH_BB        (PER_ADDR_BASE + (uintptr_t) 0x42000000) ///< Peripheral base address in the bit-band region
+#define PER_ADDR_BKPSRAM_BB       (PER_ADDR_BASE + (uintptr_t) 0x42480000) ///< Backup SRAM(4 KB) base address in the bit-band region
+#define PER_ADDR_FLASH_OTP        (PER_ADDR_BASE + (uintptr_t) 0x1FFF7800) ///< Base address of : (up to 528 Bytes) embedded FLASH OTP Area
 
 #define PER_ADDR_APB1       PER_ADDR_PERIPH ///< APB1 peripherals base
 #define PER_ADDR_APB2       (PER_ADDR_PERIPH + (uintptr_t) 0x00010000) ///< APB2 peripherals base
@@ -0,0 +1,297 @@
+#!/usr/bin/env python3
+"""
+@file per_bench.py
+
+Instruction count and code size benchmark of all the per_ accessors
+
+Copyright (c) 2023 admaunaloa admaunaloa@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+For every "static per_inline" accessor in F4/inc/*.h a probe function is
+generated that calls the accessor with its parameters. The probes are
+cross-compiled with arm-none-eabi-gcc for each optimisation level and
+disassembled. Per accessor the instruction count, a static Cortex-M4 cycle
+estimate and the size in bytes are reported, with the delta against a stored
+baseline.
+
+The descriptor parameters of the probes are run-time values, so the numbers
+are an upper bound of the cost with compile time constant descriptors.
+
+The multi-bit setters are generated by macros, so for the field sizes in
+SET_SIZES explicit probes compare the two write paths of per_bit_f4.h:
+per_bit_rwN_set_excl, the LDREX/STREX read-modify-write, and
+per_bit_rwN_set_bitband, one bitband store per bit written out. The bitband
+probe has no call and loop overhead, so it is a lower bound of
+per_bit_set_bits(). PER_BIT_SET_EXCL_SIZE should be the smallest size where
+the exclusive path is cheaper.
+
+Usage:
+    tools/per_bench.py -I <cmsis include dir>            report and compare
+    tools/per_bench.py -I <cmsis include dir> --update   store a new baseline
+    tools/per_bench.py --json result.json                also write the results
+
+The exit code is 1 when an accessor grew compared to the baseline, and 2
+when there is no baseline file and --update is not given.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+## Accessor definition
+ACCESSOR = re.compile(r'^static per_inline\s+([^;{}()]*?)\b(per_\w+)\s*\(([^()]*)\)\s*$', re.MULTILINE)
+
+## Field sizes of the setter comparison probes
+SET_SIZES = (2, 3, 4, 6, 9, 12, 16)
+
+## Parameter name is the last identifier
+PARAM_NAME = re.compile(r'(\w+)\s*(\[[^\]]*\])?$')
+
+## Static Cortex-M4 cycle estimate per mnemonic, all the others are 1 cycle
+## Loads and stores 2 (no wait states), taken branches 3 (pipeline refill), divides worst case
+CYCLES = {
+    'ldr': 2, 'ldrb': 2, 'ldrh': 2, 'ldrsb': 2, 'ldrsh': 2, 'ldrd': 3,
+    'str': 2, 'strb': 2, 'strh': 2, 'strd': 3,
+    'ldrex': 2, 'ldrexb': 2, 'ldrexh': 2, 'strex': 2, 'strexb': 2, 'strexh': 2,
+    'b': 3, 'bl': 3, 'blx': 3, 'bx': 3,
+    'sdiv': 12, 'udiv': 12,
+    'dmb': 3, 'dsb': 3, 'isb': 3,
+}
+
+
+def accessors(header):
+    """List of (name, return type, parameters) of a header"""
+    with open(header) as f:
+        text = f.read()
+
+    result = []
+
+    for ret, name, params in ACCESSOR.findall(text):
+        names = []
+
+        for param in params.split(','):
+            param = param.strip()
+
+            if param in ('', 'void'):
+                continue
+
+            match = PARAM_NAME.search(param)
+
+            if match is None:
+                break
+
+            names.append(match.group(1))
+        else:
+            result.append((name, ' '.join(ret.split()), params.strip() or 'void', names))
+
+    return result
+
+
+def probe_source(header, funcs):
+    """Probe translation unit for one header"""
+    lines = ['#include "%s"' % os.path.basename(header), '']
+
+    for name, ret, params, names in funcs:
+        call = '%s(%s)' % (name, ', '.join(names))
+        body = call + ';' if ret == 'void' else 'return ' + call + ';'
+        lines.append('%s bench_%s(%s) { %s }' % (ret, name, params, body))
+
+    return '\n'.join(lines) + '\n'
+
+
+def compare_source():
+    """Probe translation unit of the exclusive and the bitband setter of each size in SET_SIZES"""
+    lines = ['#include "per_bit_f4.h"', '']
+
+    for size in SET_SIZES:
+        field = 'per_bit_rw%d' % size
+        lines.append('bool bench_%s_set_excl(%s_t* self, uint_fast16_t value) { return %s_set_excl(self, value); }' %
+                     (field, field, field))
+        stores = ' '.join('PER_BIT_BB_SET(&self->Rw[%d], (value >> %d) & 1u);' % (bit, bit) for bit in range(size))
+        lines.append('bool bench_%s_set_bitband(%s_t* self, uint_fast16_t value) { %s return true; }' %
+                     (field, field, stores))
+
+    return '\n'.join(lines) + '\n'
+
+
+def disassemble(objdump, obj):
+    """Dictionary of function name to list of mnemonics"""
+    out = subprocess.run([objdump, '-d', '--no-show-raw-insn', obj],
+                         check=True, capture_output=True, text=True).stdout
+    funcs = {}
+    current = None
+
+    for line in out.splitlines():
+        head = re.match(r'^[0-9a-f]+ <bench_(\w+)>:$', line)
+
+        if head:
+            current = funcs.setdefault(head.group(1), [])
+            continue
+
+        insn = re.match(r'^\s+[0-9a-f]+:\s+(\S+)', line)
+
+        if insn and current is not None:
+            current.append(insn.group(1).split('.')[0])
+        elif not line.strip():
+            current = None
+
+    return funcs
+
+
+def cycles(mnems):
+    """Static cycle estimate of a list of mnemonics"""
+    total = 0
+
+    for mnem in mnems:
+        base = re.sub(r'(eq|ne|cs|hs|cc|lo|mi|pl|vs|vc|hi|ls|ge|lt|gt|le|al|s|w)+$', '', mnem)
+
+        if mnem in CYCLES:
+            total += CYCLES[mnem]
+        elif base in ('b', 'cbz', 'cbnz'):
+            total += 1 # conditional branch, not taken
+        elif base in ('push', 'pop', 'ldm', 'stm', 'ldmia', 'stmia', 'stmdb'):
+            total += 2 # one and one per register, registers unknown here
+        else:
+            total += CYCLES.get(base, 1)
+
+    return total
+
+
+def measure(args, opt, tmp):
+    """Measure all the accessors with one optimisation level"""
+    results = {}
+    flags = args.flags.split() + ['-' + opt, '-c', '-DPER_BENCH',
+             '-I' + os.path.join(ROOT, 'F4', 'inc'),
+             '-I' + os.path.join(ROOT, args.chip, 'inc'),
+             '-I' + os.path.join(ROOT, 'Bsp_example')] + ['-I' + inc for inc in args.include]
+    headers = sorted(h for h in os.listdir(os.path.join(ROOT, 'F4', 'inc')) if h.endswith('_f4.h'))
+    units = [(h, None) for h in headers] + [('per_bit_set_cmp.h', compare_source())]
+
+    for header, text in units:
+        if text is None:
+            funcs = accessors(os.path.join(ROOT, 'F4', 'inc', header))
+
+            if not funcs:
+                continue
+
+            text = probe_source(header, funcs)
+
+        src = os.path.join(tmp, header.replace('.h', '_bench.c'))
+        obj = src.replace('.c', '_' + opt + '.o')
+
+        with open(src, 'w') as f:
+            f.write(text)
+
+        build = subprocess.run([args.cc] + flags + [src, '-o', obj], capture_output=True, text=True)
+
+        if build.returncode != 0:
+            sys.stderr.write('%s -%s failed:\n%s\n' % (header, opt, build.stderr))
+            continue
+
+        size = {}
+
+        for line in subprocess.run([args.nm, '-S', obj], check=True, capture_output=True, text=True).stdout.splitlines():
+            sym = line.split()
+
+            if len(sym) == 4 and sym[3].startswith('bench_'):
+                size[sym[3][len('bench_'):]] = int(sym[1], 16)
+
+        for name, info in disassemble(args.objdump, obj).items():
+            results[name] = {'insn': len(info), 'cycles': cycles(info), 'bytes': size.get(name, 0)}
+
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description='per_ accessor instruction count and code size benchmark')
+    parser.add_argument('--cc', default='arm-none-eabi-gcc', help='compiler')
+    parser.add_argument('--objdump', default='arm-none-eabi-objdump', help='disassembler')
+    parser.add_argument('--nm', default='arm-none-eabi-nm', help='symbol lister')
+    parser.add_argument('--flags', default='-mcpu=cortex-m4 -mthumb -mfloat-abi=hard -mfpu=fpv4-sp-d16 -ffunction-sections',
+                        help='target compiler flags')
+    parser.add_argument('--opt', nargs='+', default=['O2', 'Os'], help='optimisation levels')
+    parser.add_argument('--chip', default='F439XX', help='chip variant directory')
+    parser.add_argument('-I', '--include', action='append', default=[], help='extra include directory (CMSIS)')
+    parser.add_argument('--baseline', default=os.path.join(ROOT, 'tools', 'per_bench_baseline.json'), help='baseline file')
+    parser.add_argument('--update', action='store_true', help='store the results as the new baseline')
+    parser.add_argument('--json', help='write the results to this file')
+    args = parser.parse_args()
+
+    if not args.update and not os.path.exists(args.baseline):
+        sys.stderr.write('per_bench: no baseline %s, create it with --update on the target toolchain\n' % args.baseline)
+        return 2
+
+    with tempfile.TemporaryDirectory() as tmp:
+        results = {opt: measure(args, opt, tmp) for opt in args.opt}
+
+    baseline = {}
+
+    if not args.update:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    grown = 0
+    print('%-4s %-52s %6s %6s %6s %8s' % ('opt', 'accessor', 'insn', 'cycles', 'bytes', 'delta'))
+
+    for opt, funcs in results.items():
+        for name in sorted(funcs):
+            res = funcs[name]
+            base = baseline.get(opt, {}).get(name)
+            delta = ''
+
+            if base is not None:
+                diff = res['bytes'] - base['bytes']
+                delta = '%+d' % diff if diff else '='
+                grown += diff > 0 or res['insn'] > base['insn']
+
+            print('%-4s %-52s %6d %6d %6d %8s' % (opt, name, res['insn'], res['cycles'], res['bytes'], delta))
+
+    print('\n%-4s %4s %14s %14s' % ('opt', 'size', 'excl cycles', 'bitband cycles'))
+
+    for opt, funcs in results.items():
+        for size in SET_SIZES:
+            excl = funcs.get('per_bit_rw%d_set_excl' % size)
+            band = funcs.get('per_bit_rw%d_set_bitband' % size)
+
+            if excl is not None and band is not None:
+                print('%-4s %4d %14d %14d' % (opt, size, excl['cycles'], band['cycles']))
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(results, f, indent=1, sort_keys=True)
+
+    if args.update:
+        with open(args.baseline, 'w') as f:
+            json.dump(results, f, indent=1, sort_keys=True)
+    elif grown:
+        print('%d accessors grew compared to the baseline' % grown)
+        return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
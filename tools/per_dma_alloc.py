@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""
+@file per_dma_alloc.py
+
+DMA stream and channel allocator with conflict detection
+
+Copyright (c) 2023 admaunaloa admaunaloa@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Assigns a DMA stream and channel to every peripheral request of a board from
+the PER_DMA_x_STREAM_y_<REQUEST> selections in <chip>/inc/per_dma.h. Every
+stream serves one request. The result is a header with constant descriptors:
+
+    static per_inline const per_dma_stream_t* const bsp_dma_usart3_rx(void);
+    static per_inline const per_dma_selection_t* const bsp_dma_usart3_rx_sel(void);
+
+When the requests can not all get a stream the smallest group of requests that
+compete for too few streams is reported and the exit code is 1, so a build
+rule that generates the header fails.
+
+Usage:
+    tools/per_dma_alloc.py --chip F439XX --out Bsp_example/inc/bsp_dma.h USART3_RX USART3_TX
+    tools/per_dma_alloc.py --reserve DMA2_STREAM0 SPI1_TX ADC1
+"""
+
+import argparse
+import itertools
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+## Selection definition
+SELECTION = re.compile(r'static const per_dma_selection_t (PER_DMA_([12])_STREAM_([0-7])_(\w+))\s*=\s*\{[^}]*PER_DMA_CHANNEL_([0-7])')
+
+
+def selections(chip):
+    """Dictionary of request to list of (selection, dma, stream, channel)"""
+    with open(os.path.join(ROOT, chip, 'inc', 'per_dma.h')) as f:
+        text = f.read()
+
+    result = {}
+
+    for name, dma, stream, request, chan in SELECTION.findall(text):
+        result.setdefault(request, []).append((name, int(dma), int(stream), int(chan)))
+
+    return result
+
+
+def assign(requests, options, used):
+    """Stream per request by backtracking, the most constrained request first, None when impossible"""
+    if not requests:
+        return {}
+
+    request = min(requests, key=lambda req: len([opt for opt in options[req] if opt[1:3] not in used]))
+    rest = [req for req in requests if req != request]
+
+    for opt in options[request]:
+        if opt[1:3] in used:
+            continue
+
+        result = assign(rest, options, used | {opt[1:3]})
+
+        if result is not None:
+            result[request] = opt
+            return result
+
+    return None
+
+
+def conflict(requests, options, reserved):
+    """Smallest group of requests with fewer free streams than requests"""
+    for size in range(1, len(requests) + 1):
+        for group in itertools.combinations(requests, size):
+            streams = {opt[1:3] for req in group for opt in options[req]} - reserved
+
+            if len(streams) < size:
+                return group, streams
+
+    return requests, set()
+
+
+def stream_name(stream):
+    """DMA1 STREAM3 style name"""
+    return 'DMA%d STREAM%d' % stream
+
+
+def header(name, result):
+    """Generated header text"""
+    guard = name.replace('.', '_') + '_'
+    lines = ['/**',
+             ' * @file %s' % name,
+             ' *',
+             ' * This file contains the DMA stream allocation of the board',
+             ' *',
+             ' * Generated by tools/per_dma_alloc.py, do not edit.',
+             ' */',
+             '',
+             '#ifndef %s' % guard,
+             '#define %s' % guard,
+             '',
+             '#ifdef __cplusplus',
+             'extern "C" {',
+             '#endif',
+             '',
+             '#include "per_dma.h"',
+             '']
+
+    for request in sorted(result):
+        sel, dma, stream, chan = result[request]
+        func = 'bsp_dma_' + request.lower()
+        lines += ['/// %s: DMA%d stream %d channel %d' % (request, dma, stream, chan),
+                  'static per_inline const per_dma_stream_t* const %s(void)' % func,
+                  '{',
+                  '    return per_dma_%d_stream_%d();' % (dma, stream),
+                  '}',
+                  '',
+                  '/// %s stream-channel selection' % request,
+                  'static per_inline const per_dma_selection_t* const %s_sel(void)' % func,
+                  '{',
+                  '    return &%s;' % sel,
+                  '}',
+                  '']
+
+    lines += ['#ifdef __cplusplus',
+              '}',
+              '#endif',
+              '',
+              '#endif // %s' % guard,
+              '']
+
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='DMA stream and channel allocator')
+    parser.add_argument('requests', nargs='+', help='peripheral requests, for example USART3_RX SPI1_TX ADC1')
+    parser.add_argument('--chip', default='F439XX', help='chip variant directory')
+    parser.add_argument('--reserve', action='append', default=[], help='stream not to use, for example DMA2_STREAM0')
+    parser.add_argument('--out', help='header to write, default stdout')
+    args = parser.parse_args()
+
+    options = selections(args.chip)
+    reserved = set()
+
+    for res in args.reserve:
+        match = re.match(r'^DMA([12])_STREAM([0-7])$', res)
+
+        if match is None:
+            sys.stderr.write('error: invalid reserved stream %s, use DMA<1..2>_STREAM<0..7>\n' % res)
+            return 1
+
+        reserved.add((int(match.group(1)), int(match.group(2))))
+
+    for request in args.requests:
+        if request not in options:
+            sys.stderr.write('error: %s has no DMA stream on %s, known requests: %s\n' %
+                             (request, args.chip, ' '.join(sorted(options))))
+            return 1
+
+    if len(set(args.requests)) != len(args.requests):
+        sys.stderr.write('error: duplicate request\n')
+        return 1
+
+    result = assign(args.requests, options, reserved)
+
+    if result is None:
+        group, streams = conflict(args.requests, options, reserved)
+        sys.stderr.write('error: DMA stream conflict, %d requests share %d free streams:\n' % (len(group), len(streams)))
+
+        for request in group:
+            sys.stderr.write('    %-16s %s\n' % (request, ', '.join(
+                stream_name(opt[1:3]) + (' (reserved)' if opt[1:3] in reserved else '') for opt in options[request])))
+
+        return 1
+
+    text = header(os.path.basename(args.out) if args.out else 'bsp_dma.h', result)
+
+    if args.out:
+        with open(args.out, 'w') as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+
+    for request in args.requests:
+        sys.stderr.write('%-16s %s channel %d\n' % (request, stream_name(result[request][1:3]), result[request][3]))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
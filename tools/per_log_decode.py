@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+"""
+@file per_log_decode.py
+
+Decoder of the per_log binary records
+
+Copyright (c) 2023 admaunaloa admaunaloa@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+Reads the per_log_record_t stream (per_log_encode) from a file or stdin and
+prints one line per record. The names are taken from the per_log_e enum in
+per_log_f4.h and the *_error_e enums of the drivers, so the decoder follows
+the headers without changes. Bytes between records are skipped until the next
+PER_LOG_RECORD_SYNC, the stream can be started at any point.
+
+Usage:
+    tools/per_log_decode.py capture.bin
+    cat /dev/ttyUSB0 | tools/per_log_decode.py --follow
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+## Record layout, see per_log_record_t
+RECORD = struct.Struct('<HHIII')
+SYNC = 0x5AA5
+
+## Enumeration definition
+ENUM = re.compile(r'typedef\s+enum\s*\{([^}]*)\}\s*(\w+)\s*;', re.DOTALL)
+
+## Enumerator with optional value, the last one can omit the comma
+ENUMERATOR = re.compile(r'^\s*(\w+)\s*(?:=\s*([^,/]+?))?\s*(?:,|//|/\*|$)', re.MULTILINE)
+
+
+def constant(expr, names):
+    """Value of an enumerator expression, a sum of products of numbers and earlier enumerators"""
+    total = 0
+
+    for term in expr.split('+'):
+        product = 1
+
+        for factor in term.split('*'):
+            factor = factor.strip().strip('()').strip()
+            product *= names[factor] if factor in names else int(factor.rstrip('uUlL') or '0', 0)
+
+        total += product
+
+    return total
+
+
+def enums(inc):
+    """Name and enumerator values of the per_log_e and *_error_e enums"""
+    names = {}
+
+    for header in sorted(os.listdir(inc), key=lambda h: (h != 'per_log_f4.h', h)): # Peripherals first
+        if not header.endswith('.h'):
+            continue
+
+        with open(os.path.join(inc, header)) as f:
+            text = f.read()
+
+        for body, name in ENUM.findall(text):
+            if name != 'per_log_e' and not name.endswith('_error_e'):
+                continue
+
+            value = -1
+            result = {}
+
+            for enumerator, expr in ENUMERATOR.findall(body):
+                value = constant(expr, names) if expr else value + 1
+                names[enumerator] = value
+                result[enumerator] = value
+
+            yield name, result
+
+
+def tables(inc):
+    """Peripheral and event value to name lookup tables"""
+    peripherals = {}
+    events = {}
+
+    for name, values in enums(inc):
+        for enumerator, value in values.items():
+            if name == 'per_log_e':
+                if enumerator not in ('PER_LOG_MULT', 'PER_LOG_END'):
+                    peripherals.setdefault(value, enumerator[len('PER_LOG_'):])
+            else:
+                events.setdefault(value, enumerator)
+
+    return peripherals, events
+
+
+def records(stream, follow):
+    """Records of the stream, resynchronising on the start marker"""
+    buf = b''
+
+    while True:
+        data = stream.read(1 if follow else 65536)
+
+        if not data:
+            return
+
+        buf += data
+
+        while len(buf) >= RECORD.size:
+            sync = buf.find(struct.pack('<H', SYNC))
+
+            if sync < 0:
+                buf = buf[-1:]
+                break
+
+            buf = buf[sync:]
+
+            if len(buf) < RECORD.size:
+                break
+
+            yield RECORD.unpack_from(buf)[1:]
+            buf = buf[RECORD.size:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='per_log binary record decoder')
+    parser.add_argument('file', nargs='?', help='record file, default stdin')
+    parser.add_argument('--inc', default=os.path.join(ROOT, 'F4', 'inc'), help='per_ header directory')
+    parser.add_argument('--follow', action='store_true', help='print every record as it arrives')
+    args = parser.parse_args()
+
+    peripherals, events = tables(args.inc)
+    stream = open(args.file, 'rb') if args.file else sys.stdin.buffer
+
+    for per, event, value, time in records(stream, args.follow):
+        print('%10u %-20s %-28s 0x%08x' % (time, peripherals.get(per, str(per)), events.get(event, str(event)), value),
+              flush=args.follow)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())